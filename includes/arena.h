@@ -0,0 +1,126 @@
+// Arena allocators in C Implementation code, used by the collector to store the results.
+// An Arena hands out memory from large chunks with a bump pointer and gives everything back in one shot:
+// the memory never moves, so it holds the nodes of the lists that are linked by pointers.
+// A NameStore keeps the filenames one after the other in a single growing buffer and refers to them by
+// offset, so the buffer can be reallocated and the names are read in the order they were stored.
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK (1 << 20)   // size of an arena chunk
+#define ARENA_ALIGN 16          // alignment of the memory returned by arenaAlloc
+#define NAMESTORE_INIT (1 << 16) // initial size of the name buffer
+#define NAMESTORE_NONE ((size_t)-1) // offset returned when the name cannot be stored
+
+// a chunk of the arena, the memory handed out follows the header
+struct ArenaChunk
+{
+  struct ArenaChunk *next; // previous chunk
+  size_t size;             // usable bytes after the header
+};
+
+// bump pointer allocator
+struct Arena
+{
+  struct ArenaChunk *chunks; // last allocated chunk, the others follow through next
+  char *ptr;                 // first free byte of the last chunk
+  size_t left;               // free bytes of the last chunk
+};
+
+// filenames stored back to back, each terminated by '\0'
+struct NameStore
+{
+  char *bytes; // the names
+  size_t len;  // used bytes
+  size_t cap;  // size of bytes
+};
+
+// initialize an empty arena, no memory is allocated until the first arenaAlloc
+static inline void arenaInit(struct Arena *a)
+{
+  a->chunks = NULL;
+  a->ptr = NULL;
+  a->left = 0;
+}
+
+// function to allocate size bytes from the arena. Returns NULL if the memory is exhausted
+static inline void *arenaAlloc(struct Arena *a, size_t size)
+{
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  if (size > a->left)
+  {
+    size_t csize = (size > ARENA_CHUNK) ? size : ARENA_CHUNK;
+    // the header takes ARENA_ALIGN bytes so the memory after it stays aligned
+    struct ArenaChunk *c = (struct ArenaChunk *)malloc(ARENA_ALIGN + csize);
+    if (c == NULL)
+      return NULL;
+    c->next = a->chunks;
+    c->size = csize;
+    a->chunks = c;
+    a->ptr = (char *)c + ARENA_ALIGN;
+    a->left = csize;
+  }
+  void *p = a->ptr;
+  a->ptr += size;
+  a->left -= size;
+  return p;
+}
+
+// function to free all the memory of the arena at once
+static inline void arenaRelease(struct Arena *a)
+{
+  while (a->chunks != NULL)
+  {
+    struct ArenaChunk *next = a->chunks->next;
+    free(a->chunks);
+    a->chunks = next;
+  }
+  a->ptr = NULL;
+  a->left = 0;
+}
+
+// initialize an empty name store
+static inline void namesInit(struct NameStore *s)
+{
+  s->bytes = NULL;
+  s->len = s->cap = 0;
+}
+
+// function to copy a filename in the store. Returns its offset, NAMESTORE_NONE if the memory is exhausted
+static inline size_t internName(struct NameStore *s, const char *name)
+{
+  size_t size = strlen(name) + 1;
+  if (s->len + size > s->cap)
+  {
+    size_t cap = (s->cap > 0) ? s->cap : NAMESTORE_INIT;
+    while (s->len + size > cap)
+      cap *= 2;
+    char *bytes = (char *)realloc(s->bytes, cap);
+    if (bytes == NULL)
+      return NAMESTORE_NONE;
+    s->bytes = bytes;
+    s->cap = cap;
+  }
+  size_t off = s->len;
+  memcpy(s->bytes + off, name, size);
+  s->len += size;
+  return off;
+}
+
+// the filename stored at offset off (valid until the next internName)
+static inline char *nameAt(const struct NameStore *s, size_t off)
+{
+  return s->bytes + off;
+}
+
+// function to free the memory of the name store
+static inline void namesRelease(struct NameStore *s)
+{
+  free(s->bytes);
+  namesInit(s);
+}
+
+#endif // ARENA_H
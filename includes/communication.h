@@ -22,6 +22,32 @@
 #define SOCKNAME "./farm.sck"
 #endif
 
+/*
+ * Protocollo tra farm e collector: ogni messaggio inizia con un long, il codice del messaggio.
+ * Versione 1: MSG_RESULT seguito da risultato, lunghezza del pathname (compreso il '\0') e pathname.
+ * Versione 2: il worker apre la connessione con MSG_HELLO seguito dalla versione richiesta, il collector
+ * risponde con un long, la versione accettata. Con la versione 2 i risultati viaggiano in frame: MSG_FRAME
+ * seguito dalla lunghezza in byte del frame e da una sequenza di record (risultato, lunghezza, pathname)
+ * codificati come nella versione 1 ma senza codice. Le connessioni senza MSG_HELLO usano la versione 1.
+ * Versione 3: dopo l'handshake il worker invia MSG_RING con i descrittori di un anello in memoria condivisa
+ * (shmring.h) come dati ausiliari SCM_RIGHTS; il collector risponde PROTO_V3 se consumera' i risultati
+ * dall'anello, PROTO_V2 se non puo' usarlo (il worker passa ai frame). Il socket resta aperto: la sua
+ * chiusura indica che il worker ha finito.
+ */
+#define MSG_RESULT 0 // risultato di un file
+#define MSG_PRINT 1  // stampa dei risultati ricevuti finora
+#define MSG_EXIT 2   // terminazione
+#define MSG_HELLO 3  // handshake della versione
+#define MSG_FRAME 4  // frame di risultati (versione 2)
+#define MSG_RING 5   // descrittori dell'anello in memoria condivisa (versione 3)
+
+#define PROTO_INPROC 0 // nessun socket: i worker consegnano i frame al collector interno alla farm (inproc.h)
+#define PROTO_V1 1
+#define PROTO_V2 2
+#define PROTO_V3 3
+#define RING_FDS 3 // descrittori passati con MSG_RING: regione, eventfd data, eventfd space
+#define FRAME_MAX (1 << 20) // lunghezza massima di un frame accettata dal collector
+
 /** Evita letture parziali
  *
  *   \retval -1   errore (errno settato)
@@ -0,0 +1,48 @@
+/**************************/
+//  header file inproc.h   /
+/*========================*/
+
+/**
+ * @brief: collector interno alla farm (--inproc-collector): un thread del processo farm raccoglie i risultati
+ *         al posto del processo collector, senza fork, exec e socket. I worker gli consegnano i frame del
+ *         protocollo 2 (sender.h) attraverso una coda in memoria; la stampa ha lo stesso formato del collector.
+ *         Il thread attende su un semaforo, cosi' anche il signal handler di SIGUSR1 puo' chiedere una stampa
+ *         (sem_post e' async-signal-safe).
+ */
+
+#ifndef INPROC_H
+#define INPROC_H
+
+// include
+#include <stddef.h>
+
+/**
+ * @function inprocStart
+ * @brief avvia il thread collector, in modalita' append se append_mode e' diverso da 0 (vedi results.h); se
+ *        journal non e' NULL i risultati vengono accodati al journal, ricaricandolo prima se resume e' diverso da 0
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int inprocStart(int append_mode, const char *journal, int resume);
+
+/**
+ * @function inprocPush
+ * @brief consegna al collector un frame di len byte allocato con malloc, che passa al collector
+ * @return 0 in caso di successo, -1 in caso di errore (il frame viene comunque liberato)
+ */
+int inprocPush(char *frame, size_t len);
+
+/**
+ * @function inprocPrint
+ * @brief chiede al collector di stampare i risultati ricevuti finora; puo' essere chiamata da un signal handler
+ */
+void inprocPrint(void);
+
+/**
+ * @function inprocStop
+ * @brief chiede al collector di terminare dopo aver memorizzato i frame gia' consegnati, ne attende la
+ *        stampa finale e libera le risorse. Va chiamata quando i worker hanno terminato
+ * @return 0 in caso di successo, -1 in caso di errore
+ */
+int inprocStop(void);
+
+#endif // INPROC_H
@@ -0,0 +1,104 @@
+/**************************/
+//  header file journal.h  /
+/*========================*/
+
+/**
+ * @brief: journal dei risultati (--journal <file>): il collector vi accoda ogni risultato ricevuto, con lo stesso
+ *         formato dei record di un frame (risultato, lunghezza, pathname con '\0', communication.h). I record
+ *         vengono scritti ad ogni ciclo del collector e resi persistenti con fdatasync a lotti, al piu' ogni
+ *         JOURNAL_SYNC_MS ms o JOURNAL_SYNC_BYTES byte; un'interruzione perde solo l'ultimo lotto non sincronizzato.
+ *         Con --resume il collector ricarica i risultati del journal e la farm salta i file che vi compaiono
+ *         (confrontando il pathname cosi' come era stato passato alla farm), per cui una nuova esecuzione
+ *         calcola solo i file rimasti. Un record finale incompleto viene scartato.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// include
+#include <stddef.h>
+#include <time.h>
+
+// intervallo massimo in ms tra la scrittura di un record e la sua sincronizzazione
+#define JOURNAL_SYNC_MS 1000
+// byte scritti dopo i quali il journal viene sincronizzato subito
+#define JOURNAL_SYNC_BYTES (1 << 20)
+
+/**
+ *  @struct journal_t
+ *  @brief journal aperto in scrittura
+ *
+ *  @var fd       descrittore del file
+ *  @var buf      record non ancora scritti
+ *  @var len      byte in buf
+ *  @var cap      dimensione di buf
+ *  @var unsynced byte scritti e non ancora sincronizzati
+ *  @var oldest   istante della prima scrittura non sincronizzata
+ */
+typedef struct journal_t
+{
+    int fd;
+    char *buf;
+    size_t len;
+    size_t cap;
+    size_t unsynced;
+    struct timespec oldest;
+} journal_t;
+
+/**
+ * @function journalLoad
+ * @brief chiama fun(risultato, pathname, arg) per ogni record completo del journal path
+ * @return la lunghezza in byte dei record completi, -1 in caso di errore ed errno settato
+ */
+long journalLoad(const char *path, int (*fun)(long, const char *, void *), void *arg);
+
+/**
+ * @function journalOpen
+ * @brief apre il journal path: se resume e' 0 lo svuota, altrimenti scarta l'eventuale record incompleto
+ *        in fondo e vi accoda i nuovi record
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int journalOpen(journal_t *j, const char *path, int resume);
+
+/**
+ * @function journalAppend
+ * @brief accoda al journal il risultato result del file name
+ * @return 0 in caso di successo, -1 se la memoria e' esaurita
+ */
+int journalAppend(journal_t *j, long result, const char *name);
+
+/**
+ * @function journalSync
+ * @brief scrive i record accodati e li sincronizza se e' passato JOURNAL_SYNC_MS dalla prima scrittura non
+ *        sincronizzata, se ne sono stati scritti JOURNAL_SYNC_BYTES o se force e' diverso da 0
+ * @return i ms dopo i quali va richiamata perche' ci sono scritture non sincronizzate, -1 se non ce ne sono
+ */
+int journalSync(journal_t *j, int force);
+
+/**
+ * @function journalClose
+ * @brief scrive e sincronizza i record rimasti e chiude il journal
+ */
+void journalClose(journal_t *j);
+
+/**
+ * @function journalSkipLoad
+ * @brief carica l'insieme dei pathname presenti nel journal path, usato da journalSkip
+ * @return 0 in caso di successo (anche se il journal non esiste), -1 in caso di errore ed errno settato
+ */
+int journalSkipLoad(const char *path);
+
+/**
+ * @function journalSkip
+ * @return 1 se il file name compare nel journal caricato con journalSkipLoad, 0 altrimenti (thread safe
+ *         dopo il caricamento)
+ */
+int journalSkip(const char *name);
+
+/**
+ * @function journalSkipFree
+ * @brief libera l'insieme caricato con journalSkipLoad
+ */
+void journalSkipFree(void);
+
+#endif // JOURNAL_H
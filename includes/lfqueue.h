@@ -0,0 +1,84 @@
+/***************************/
+//  header file lfqueue.h   /
+/*=========================*/
+
+/**
+ * @brief: coda circolare limitata lock-free multi-produttore multi-consumatore usata come coda dei task
+ *         pendenti del threadpool (backend POOL_QUEUE_LOCKFREE). Ogni slot ha un numero di sequenza che
+ *         indica se lo slot e' libero per il produttore della posizione pos (seq == pos) oppure pieno per il
+ *         consumatore della posizione pos (seq == pos + 1): produttori e consumatori si contendono solo
+ *         l'indice di coda/testa con una compare-and-swap, senza lock.
+ *         Le operazioni atomiche usano i builtin __atomic di gcc (stesso modello di memoria di C11).
+ */
+
+#ifndef LFQUEUE_H
+#define LFQUEUE_H
+
+// include
+#include <stddef.h>
+#include <threadpool.h>
+
+// dimensione di una linea di cache, separa gli indici di produttori e consumatori (false sharing)
+#define CACHE_LINE 64
+
+// numero minimo di slot perche' i numeri di sequenza distinguano slot pieni e liberi
+#define LFQ_MIN_CAP 2
+
+/**
+ *  @struct lfslot_t
+ *  @brief slot della coda
+ *
+ *  @var seq  numero di sequenza dello slot
+ *  @var task task memorizzato nello slot
+ */
+typedef struct lfslot_t
+{
+    size_t seq;
+    taskfun_t task;
+} lfslot_t;
+
+/**
+ *  @struct lfqueue_t
+ *  @brief coda lock-free
+ *
+ *  @var slots array degli slot
+ *  @var cap   numero di slot
+ *  @var tail  prossima posizione in cui inserire (produttori)
+ *  @var head  prossima posizione da cui estrarre (consumatori)
+ */
+typedef struct lfqueue_t
+{
+    lfslot_t *slots;
+    size_t cap;
+    size_t tail __attribute__((aligned(CACHE_LINE)));
+    size_t head __attribute__((aligned(CACHE_LINE)));
+} lfqueue_t;
+
+/**
+ * @function lfqCreate
+ * @brief crea una coda con cap slot (almeno LFQ_MIN_CAP)
+ * @return la coda oppure NULL ed errno settato
+ */
+lfqueue_t *lfqCreate(size_t cap);
+
+/**
+ * @function lfqPush
+ * @brief inserisce un task in coda
+ * @return 0 in caso di successo, -1 se la coda e' piena
+ */
+int lfqPush(lfqueue_t *q, const taskfun_t *task);
+
+/**
+ * @function lfqPop
+ * @brief estrae il task in testa alla coda
+ * @return 0 in caso di successo, -1 se la coda e' vuota
+ */
+int lfqPop(lfqueue_t *q, taskfun_t *task);
+
+/**
+ * @function lfqDestroy
+ * @brief libera la coda (i task eventualmente presenti non vengono liberati)
+ */
+void lfqDestroy(lfqueue_t *q);
+
+#endif // LFQUEUE_H
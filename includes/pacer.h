@@ -0,0 +1,76 @@
+/**************************/
+//  header file pacer.h    /
+/*========================*/
+
+/**
+ * @brief: limite alla velocita' di sottomissione dei file (-t, --rate-files, --rate-bytes), realizzato con un
+ *         token bucket per i file e uno per i byte. Ogni secchio e' rappresentato dall'istante (CLOCK_MONOTONIC)
+ *         in cui tornerebbe pieno: chi sottomette un file prenota il suo costo sotto lock e attende, senza
+ *         lock, la propria scadenza. Un secchio pieno concede una raffica di PACER_BURST_MS ms di budget, per
+ *         cui l'esplorazione prosegue senza fermarsi finche' resta sotto il limite medio; un file piu' grande
+ *         del secchio attende il tempo necessario ad accumulare il suo costo.
+ */
+
+#ifndef PACER_H
+#define PACER_H
+
+// include
+#include <signal.h>
+#include <sys/types.h>
+#include <pthread.h>
+#include <time.h>
+
+// budget in ms concesso in una raffica da un secchio pieno (--rate-files, --rate-bytes)
+#define PACER_BURST_MS 100
+// attesa massima in ms tra due controlli del flag di terminazione
+#define PACER_POLL_MS 200
+
+/**
+ *  @struct pacer_t
+ *  @brief token bucket dei file e dei byte sottomessi
+ *
+ *  @var lock     mutua esclusione sulle prenotazioni
+ *  @var origin   istante di creazione, gli istanti sono in ns da origin
+ *  @var file_ns  costo in ns di un file, 0 nessun limite sui file
+ *  @var byte_ns  costo in ns di un byte, 0 nessun limite sui byte
+ *  @var file_cap capacita' in ns del secchio dei file
+ *  @var byte_cap capacita' in ns del secchio dei byte
+ *  @var file_tat istante in cui il secchio dei file torna pieno
+ *  @var byte_tat istante in cui il secchio dei byte torna pieno
+ */
+typedef struct pacer_t
+{
+    pthread_mutex_t lock;
+    struct timespec origin;
+    double file_ns;
+    double byte_ns;
+    double file_cap;
+    double byte_cap;
+    double file_tat;
+    double byte_tat;
+} pacer_t;
+
+/**
+ * @function createPacer
+ * @brief crea il limite di files_rate file al secondo e bytes_rate byte al secondo (0 nessun limite) con raffiche
+ *        di PACER_BURST_MS ms; se interval_ms e' maggiore di 0 i file sono inoltre distanziati di almeno
+ *        interval_ms ms, senza raffiche (-t)
+ * @return il limite oppure NULL ed errno settato
+ */
+pacer_t *createPacer(double files_rate, double bytes_rate, long interval_ms);
+
+/**
+ * @function pacerWait
+ * @brief prenota la sottomissione di un file di bytes byte e attende che rientri nel limite, oppure che *stop
+ *        diventi diverso da 0 (stop puo' essere NULL). Puo' essere chiamata da piu' thread
+ * @return 0 se il file puo' essere sottomesso, 1 se l'attesa e' stata interrotta da stop
+ */
+int pacerWait(pacer_t *p, off_t bytes, volatile sig_atomic_t *stop);
+
+/**
+ * @function destroyPacer
+ * @brief libera il limite
+ */
+void destroyPacer(pacer_t *p);
+
+#endif // PACER_H
@@ -0,0 +1,54 @@
+/*****************************/
+//  header file pathalloc.h   /
+/*===========================*/
+
+/**
+ * @brief: allocatore a slab per i pathname e gli altri piccoli argomenti dei task del threadpool.
+ *         I blocchi sono divisi in classi di dimensione (da 32 byte a PATH_MAX) e ritagliati da slab
+ *         di PATHALLOC_SLAB byte; ogni thread tiene una lista di blocchi liberi per classe e scambia
+ *         lotti di blocchi con un deposito globale protetto da mutex. In questo modo il master che
+ *         alloca e i worker che liberano non si contendono malloc, e ogni pathname occupa un blocco
+ *         proporzionato alla sua lunghezza invece di NAME_MAX byte.
+ */
+
+#ifndef PATHALLOC_H
+#define PATHALLOC_H
+
+// include
+#include <stddef.h>
+
+/**
+ * @function pathAlloc
+ * @brief alloca un blocco di almeno size byte (thread safe)
+ * @return il blocco oppure NULL ed errno settato
+ */
+void *pathAlloc(size_t size);
+
+/**
+ * @function pathDup
+ * @brief copia la stringa s in un blocco della classe adatta alla sua lunghezza
+ * @return la copia oppure NULL ed errno settato
+ */
+char *pathDup(const char *s);
+
+/**
+ * @function pathFree
+ * @brief restituisce un blocco ottenuto con pathAlloc o pathDup, anche da un thread diverso da quello
+ *        che lo ha allocato. Non fa niente se p e' NULL
+ */
+void pathFree(void *p);
+
+/**
+ * @function pathallocThreadFlush
+ * @brief restituisce al deposito globale i blocchi liberi del thread chiamante, da chiamare prima
+ *        che un thread che ha usato l'allocatore termini
+ */
+void pathallocThreadFlush(void);
+
+/**
+ * @function pathallocCleanup
+ * @brief libera tutti gli slab, da chiamare quando nessun thread usa piu' l'allocatore
+ */
+void pathallocCleanup(void);
+
+#endif // PATHALLOC_H
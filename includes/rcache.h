@@ -0,0 +1,118 @@
+/**************************/
+//  header file rcache.h   /
+/*========================*/
+
+/**
+ * @brief: cache persistente dei risultati (-C <file>). Il file della cache contiene una tabella hash ad
+ *         indirizzamento aperto (scansione lineare) mappata in memoria con MAP_SHARED, per cui i risultati
+ *         memorizzati restano su disco tra un'esecuzione e l'altra della farm. Un file e' identificato da
+ *         (st_dev, st_ino) e il risultato in cache e' valido solo se st_size e st_mtim coincidono con quelli
+ *         registrati; altrimenti il file viene ricalcolato e il suo elemento sovrascritto.
+ *         In modalita' incrementale (-i, --append-only) un risultato non piu' valido fa da checkpoint per i file
+ *         che crescono solo in coda: il risultato e' prefix-decomponibile, per cui basta calcolare i long
+ *         aggiunti dopo la vecchia dimensione. La modalita' va chiesta esplicitamente perche' ASSUME che i file
+ *         cresciuti siano stati solo estesi: rileggere tutto il prefisso per verificarlo costerebbe quanto
+ *         ricalcolarlo. Ogni elemento registra un controllo (rcacheCheck) sui primi e sugli ultimi long del
+ *         prefisso, che viene riletto per accorgersi dei file riscritti (troncati e riscritti da capo, o con la
+ *         vecchia coda modificata); una modifica nel mezzo del prefisso non viene rilevata e produce un
+ *         risultato errato.
+ *         La tabella e' unica per processo e protetta da un mutex; il file viene bloccato con flock
+ *         per tutta l'esecuzione, una seconda farm sulla stessa cache lavora senza cache.
+ */
+
+#ifndef RCACHE_H
+#define RCACHE_H
+
+// include
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ *  @struct rckey_t
+ *  @brief identita' e versione di un file
+ *
+ *  @var dev   dispositivo (st_dev)
+ *  @var ino   i-node (st_ino)
+ *  @var size  dimensione in byte (st_size)
+ *  @var sec   secondi dell'ultima modifica (st_mtim)
+ *  @var nsec  nanosecondi dell'ultima modifica (st_mtim)
+ */
+typedef struct rckey_t
+{
+    unsigned long dev;
+    unsigned long ino;
+    long size;
+    long sec;
+    long nsec;
+} rckey_t;
+
+// numero di long alla fine del prefisso coperti dal controllo di un checkpoint
+#define RCACHE_CHECK_LONGS 64
+
+/**
+ * @function rcacheOpen
+ * @brief apre (creandolo se non esiste) il file della cache path e lo mappa in memoria; un file che non
+ *        contiene una cache valida viene reinizializzato. Se incremental e' diverso da 0 i risultati
+ *        memorizzati vengono usati anche come checkpoint (rcachePrefix)
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato (la farm prosegue senza cache)
+ */
+int rcacheOpen(const char *path, int incremental);
+
+/**
+ * @function rcacheEnabled
+ * @return 1 se la cache e' aperta, 0 altrimenti
+ */
+int rcacheEnabled(void);
+
+/**
+ * @function rcacheIncremental
+ * @return 1 se la cache e' aperta in modalita' incrementale, 0 altrimenti
+ */
+int rcacheIncremental(void);
+
+/**
+ * @function rcacheKey
+ * @brief ricava da st la chiave del file
+ */
+void rcacheKey(const struct stat *st, rckey_t *key);
+
+/**
+ * @function rcacheLookup
+ * @brief cerca il risultato del file key (thread safe)
+ * @return 1 e il risultato in result se la cache contiene un risultato valido, 0 altrimenti
+ */
+int rcacheLookup(const rckey_t *key, long *result);
+
+/**
+ * @function rcachePrefix
+ * @brief cerca un checkpoint per il file key (thread safe): il risultato di una versione precedente del file,
+ *        piu' corta, che puo' esserne un prefisso
+ * @param size   riceve la dimensione in byte della versione precedente
+ * @param result riceve il suo risultato
+ * @param check  riceve il controllo dei suoi primi e ultimi long (rcacheCheck)
+ * @return 1 se c'e' un checkpoint e la cache e' in modalita' incrementale, 0 altrimenti
+ */
+int rcachePrefix(const rckey_t *key, long *size, long *result, unsigned long *check);
+
+/**
+ * @function rcacheCheck
+ * @brief calcola il controllo dei primi e degli ultimi RCACHE_CHECK_LONGS long (o meno se il file e' piu' corto)
+ *        tra i primi nelem long del file fd, leggendoli con pread
+ * @return il controllo, 0 se nelem e' 0 o la lettura fallisce (un controllo 0 non viene mai accettato)
+ */
+unsigned long rcacheCheck(int fd, long nelem);
+
+/**
+ * @function rcacheStore
+ * @brief memorizza il risultato del file key e il controllo check dei suoi long, sostituendo quello
+ *        di una versione precedente (thread safe). Non fa niente se la cache non e' aperta
+ */
+void rcacheStore(const rckey_t *key, long result, unsigned long check);
+
+/**
+ * @function rcacheClose
+ * @brief chiude la cache, i risultati memorizzati restano nel file, da chiamare quando i worker hanno terminato
+ */
+void rcacheClose(void);
+
+#endif // RCACHE_H
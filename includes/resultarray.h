@@ -0,0 +1,231 @@
+// Array of results in C Implementation code, used by the collector in append mode:
+// results are appended in arrival order and the array is sorted (ascending result, the newest first among
+// equal results, as in sortedlist.h) only when the list has to be printed.
+// The new tail is sorted in place with an MSD radix sort (American flag sort) on the result and then merged
+// with the part already sorted at the previous print, so each result is sorted only once.
+// The filenames are kept in a name store (arena.h) and the array holds their offsets, so sorting moves only
+// the keys, the arrival numbers and the offsets.
+
+#ifndef RESULTARRAY_H
+#define RESULTARRAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arena.h>
+
+#define RESULTARRAY_INIT 1024    // initial capacity
+#define RESULTARRAY_SMALL 32     // buckets up to this size are sorted with insertion sort
+#define RESULTARRAY_DIGITS 16    // radix digits: 8 bytes of result, 8 bytes of arrival number
+
+// the array: keys, arrival numbers and name offsets in separate arrays, the first sorted ones are in order
+struct ResultArray
+{
+  long *keys;           // results
+  unsigned long *seqs;  // arrival number of every result (to put the newest first among equal results)
+  size_t *names;        // offsets of the filenames in the name store
+  size_t n;             // number of results
+  size_t cap;           // capacity of the arrays
+  size_t sorted;        // the first sorted results are in order
+  unsigned long next;   // arrival number of the next result
+  struct NameStore store; // filenames
+};
+
+// create an empty array
+struct ResultArray *newArray(void)
+{
+  struct ResultArray *a = (struct ResultArray *)malloc(sizeof(struct ResultArray));
+  if (a == NULL)
+    return NULL;
+  a->cap = RESULTARRAY_INIT;
+  a->keys = (long *)malloc(sizeof(long) * a->cap);
+  a->seqs = (unsigned long *)malloc(sizeof(unsigned long) * a->cap);
+  a->names = (size_t *)malloc(sizeof(size_t) * a->cap);
+  if (a->keys == NULL || a->seqs == NULL || a->names == NULL)
+  {
+    free(a->keys);
+    free(a->seqs);
+    free(a->names);
+    free(a);
+    return NULL;
+  }
+  a->n = a->sorted = 0;
+  a->next = 0;
+  namesInit(&a->store);
+  return a;
+}
+
+// function to append a result, filename is copied. Returns 0 on success, -1 if the memory is exhausted
+int appendResult(struct ResultArray *a, long data, char *filename)
+{
+  if (a->n == a->cap)
+  {
+    size_t cap = a->cap * 2;
+    long *keys = (long *)realloc(a->keys, sizeof(long) * cap);
+    if (keys != NULL)
+      a->keys = keys;
+    unsigned long *seqs = (unsigned long *)realloc(a->seqs, sizeof(unsigned long) * cap);
+    if (seqs != NULL)
+      a->seqs = seqs;
+    size_t *names = (size_t *)realloc(a->names, sizeof(size_t) * cap);
+    if (names != NULL)
+      a->names = names;
+    if (keys == NULL || seqs == NULL || names == NULL)
+      return -1;
+    a->cap = cap;
+  }
+  size_t name = internName(&a->store, filename);
+  if (name == NAMESTORE_NONE)
+    return -1;
+  a->keys[a->n] = data;
+  a->seqs[a->n] = a->next++;
+  a->names[a->n] = name;
+  a->n++;
+  return 0;
+}
+
+// digit d (0 is the most significant) of the sort key of element i: the result with the sign bit flipped
+// (so that it orders as unsigned) followed by the complement of the arrival number (the newest first)
+static inline unsigned digitAt(const struct ResultArray *a, size_t i, int d)
+{
+  unsigned long k = (d < 8) ? (unsigned long)a->keys[i] ^ (1UL << 63) : ~a->seqs[i];
+  return (unsigned)(k >> (56 - 8 * (d % 8))) & 0xff;
+}
+
+// 1 if element i comes before element j
+static inline int beforeAt(const struct ResultArray *a, size_t i, size_t j)
+{
+  return a->keys[i] < a->keys[j] || (a->keys[i] == a->keys[j] && a->seqs[i] > a->seqs[j]);
+}
+
+static inline void swapAt(struct ResultArray *a, size_t i, size_t j)
+{
+  long k = a->keys[i];
+  a->keys[i] = a->keys[j];
+  a->keys[j] = k;
+  unsigned long s = a->seqs[i];
+  a->seqs[i] = a->seqs[j];
+  a->seqs[j] = s;
+  size_t p = a->names[i];
+  a->names[i] = a->names[j];
+  a->names[j] = p;
+}
+
+// sort the elements in [lo, hi) on the digits from d on, in place
+static void radixSort(struct ResultArray *a, size_t lo, size_t hi, int d)
+{
+  if (hi - lo <= RESULTARRAY_SMALL || d == RESULTARRAY_DIGITS)
+  {
+    for (size_t i = lo + 1; i < hi; i++)
+      for (size_t j = i; j > lo && beforeAt(a, j, j - 1); j--)
+        swapAt(a, j, j - 1);
+    return;
+  }
+
+  size_t count[256] = {0};
+  for (size_t i = lo; i < hi; i++)
+    count[digitAt(a, i, d)]++;
+
+  // bucket boundaries, then every element is swapped straight into its bucket
+  size_t next[256], end[256];
+  size_t pos = lo;
+  for (int b = 0; b < 256; b++)
+  {
+    next[b] = pos;
+    pos += count[b];
+    end[b] = pos;
+  }
+  for (int b = 0; b < 256; b++)
+  {
+    while (next[b] < end[b])
+    {
+      unsigned v = digitAt(a, next[b], d);
+      if ((int)v == b)
+        next[b]++;
+      else
+        swapAt(a, next[b], next[v]++);
+    }
+  }
+
+  for (int b = 0; b < 256; b++)
+  {
+    size_t from = (b == 0) ? lo : end[b - 1];
+    if (end[b] - from > 1)
+      radixSort(a, from, end[b], d + 1);
+  }
+}
+
+// function to sort the array: sorts the results appended since the last call and merges them with the
+// ones already sorted. Returns 0 on success, -1 if the memory is exhausted
+int sortArray(struct ResultArray *a)
+{
+  size_t m = a->n - a->sorted;
+  if (m == 0)
+    return 0;
+  radixSort(a, a->sorted, a->n, 0);
+  if (a->sorted == 0)
+  {
+    a->sorted = a->n;
+    return 0;
+  }
+
+  // backward merge: the tail is moved aside and the two parts are merged from the end of the array
+  long *keys = (long *)malloc(sizeof(long) * m);
+  unsigned long *seqs = (unsigned long *)malloc(sizeof(unsigned long) * m);
+  size_t *names = (size_t *)malloc(sizeof(size_t) * m);
+  if (keys == NULL || seqs == NULL || names == NULL)
+  {
+    free(keys);
+    free(seqs);
+    free(names);
+    return -1;
+  }
+  memcpy(keys, &a->keys[a->sorted], sizeof(long) * m);
+  memcpy(seqs, &a->seqs[a->sorted], sizeof(unsigned long) * m);
+  memcpy(names, &a->names[a->sorted], sizeof(size_t) * m);
+
+  size_t i = a->sorted, j = m, k = a->n;
+  while (j > 0)
+  {
+    k--;
+    // among equal results the older sorted ones go after the new ones
+    if (i > 0 && a->keys[i - 1] >= keys[j - 1])
+    {
+      i--;
+      a->keys[k] = a->keys[i];
+      a->seqs[k] = a->seqs[i];
+      a->names[k] = a->names[i];
+    }
+    else
+    {
+      j--;
+      a->keys[k] = keys[j];
+      a->seqs[k] = seqs[j];
+      a->names[k] = names[j];
+    }
+  }
+  free(keys);
+  free(seqs);
+  free(names);
+  a->sorted = a->n;
+  return 0;
+}
+
+// function to print the array on out, in order if sortArray has been called after the last append
+void printArray(struct ResultArray *a, FILE *out)
+{
+  for (size_t i = 0; i < a->n; i++)
+    fprintf(out, "%ld %s \n", a->keys[i], nameAt(&a->store, a->names[i]));
+}
+
+// function to free the memory allocated for the array
+void free_array(struct ResultArray *a)
+{
+  namesRelease(&a->store); // all the filenames at once
+  free(a->keys);
+  free(a->seqs);
+  free(a->names);
+  free(a);
+}
+
+#endif // RESULTARRAY_H
@@ -0,0 +1,93 @@
+/***************************/
+//  header file results.h   /
+/*=========================*/
+
+/**
+ * @brief: risultati ricevuti dal collector, comuni al processo collector e al collector interno alla farm
+ *         (inproc.h): la lista ordinata (sortedlist.h) oppure, in modalita' append, l'array ordinato solo
+ *         quando va stampato (resultarray.h). La stampa ha lo stesso formato in entrambi i casi.
+ *         Con un journal (journal.h) ogni risultato memorizzato viene anche accodato al journal.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+// include
+#include <stddef.h>
+#include <stdio.h>
+
+struct SortedList;
+struct ResultArray;
+struct journal_t;
+
+/**
+ *  @struct results_t
+ *  @brief risultati ricevuti: lista ordinata oppure, in modalita' append, array ordinato solo alla stampa
+ *
+ *  @var list    lista ordinata, NULL in modalita' append
+ *  @var array   array dei risultati, NULL se non in modalita' append
+ *  @var journal journal dei risultati, NULL se non richiesto
+ */
+typedef struct results_t
+{
+    struct SortedList *list;
+    struct ResultArray *array;
+    struct journal_t *journal;
+} results_t;
+
+/**
+ * @function resultsInit
+ * @brief crea l'insieme vuoto dei risultati, in modalita' append se append_mode e' diverso da 0
+ * @return 0 in caso di successo, -1 se la memoria e' esaurita
+ */
+int resultsInit(results_t *res, int append_mode);
+
+/**
+ * @function resultsJournal
+ * @brief accoda d'ora in poi i risultati al journal path; se resume e' diverso da 0 i risultati gia' presenti
+ *        nel journal vengono prima ricaricati in res
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int resultsJournal(results_t *res, const char *path, int resume);
+
+/**
+ * @function resultsStore
+ * @brief memorizza il risultato result del file filename (che viene copiato)
+ * @return 0 in caso di successo, -1 se la memoria e' esaurita
+ */
+int resultsStore(results_t *res, long result, char *filename);
+
+/**
+ * @function resultsStoreFrame
+ * @brief memorizza tutti i record (risultato, lunghezza, pathname) di un frame di len byte (protocollo 2,
+ *        communication.h); i pathname vengono terminati con '\0' nel frame stesso
+ * @return 0 in caso di successo, -1 se il frame non rispetta il protocollo o la memoria e' esaurita
+ */
+int resultsStoreFrame(results_t *res, char *p, size_t len);
+
+/**
+ * @function resultsSync
+ * @brief scrive sul journal i risultati accodati e li sincronizza quando necessario (journalSync)
+ * @return i ms entro cui va richiamata, -1 se non ci sono risultati da sincronizzare o non c'e' un journal
+ */
+int resultsSync(results_t *res);
+
+/**
+ * @function resultsWrite
+ * @brief scrive su out i risultati in ordine crescente, una riga "risultato pathname" per file
+ */
+void resultsWrite(results_t *res, FILE *out);
+
+/**
+ * @function resultsPrint
+ * @brief stampa su stdout i risultati in ordine crescente (resultsWrite)
+ */
+void resultsPrint(results_t *res);
+
+/**
+ * @function resultsFree
+ * @brief libera la memoria dei risultati e chiude l'eventuale journal dopo averlo sincronizzato
+ */
+void resultsFree(results_t *res);
+
+#endif // RESULTS_H
@@ -0,0 +1,84 @@
+/*****************************/
+//  header file scheduler.h   /
+/*===========================*/
+
+/**
+ * @brief: questo header file contiene la coda con priorita' usata dal master per la politica di
+ *         schedulazione LPT (Longest Processing Time first): i file candidati vengono inseriti in un
+ *         max-heap ordinato per st_size e sottomessi al threadpool dal piu' grande al piu' piccolo.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// include
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ *  @struct sched_item_t
+ *  @brief file candidato in attesa di essere sottomesso
+ *
+ *  @var file_name pathname del file (allocato dinamicamente)
+ *  @var st        risultato della stat del file
+ */
+typedef struct sched_item_t
+{
+    char *file_name;
+    struct stat st;
+} sched_item_t;
+
+/**
+ *  @struct scheduler_t
+ *  @brief max-heap di file candidati ordinato per dimensione
+ *
+ *  @var heap   array che memorizza l'heap
+ *  @var count  numero di elementi nell'heap
+ *  @var cap    capacita' dell'array heap
+ *  @var window numero massimo di file trattenuti (finestra di lookahead), 0 nessun limite
+ */
+typedef struct scheduler_t
+{
+    sched_item_t *heap;
+    size_t count;
+    size_t cap;
+    size_t window;
+} scheduler_t;
+
+/**
+ * @function createScheduler
+ * @brief crea uno scheduler vuoto
+ * @param window dimensione della finestra di lookahead, 0 per trattenere tutti i file
+ * @return lo scheduler oppure NULL ed errno settato
+ */
+scheduler_t *createScheduler(size_t window);
+
+/**
+ * @function schedPush
+ * @brief inserisce un file candidato (il pathname viene copiato)
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int schedPush(scheduler_t *s, const char *file_name, const struct stat *st);
+
+/**
+ * @function schedFull
+ * @brief indica se lo scheduler trattiene piu' file di quelli concessi dalla finestra
+ * @return 1 se bisogna estrarre un file, 0 altrimenti
+ */
+int schedFull(const scheduler_t *s);
+
+/**
+ * @function schedPop
+ * @brief estrae il file piu' grande, il chiamante deve liberare item->file_name
+ * @return 0 in caso di successo, -1 se lo scheduler e' vuoto
+ */
+int schedPop(scheduler_t *s, sched_item_t *item);
+
+/**
+ * @function destroyScheduler
+ * @brief libera lo scheduler e gli eventuali file non estratti
+ */
+void destroyScheduler(scheduler_t *s);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,92 @@
+/**************************/
+//  header file sender.h   /
+/*========================*/
+
+/**
+ * @brief: invio dei risultati di un worker al collector (protocollo in communication.h).
+ *         Con la versione 2 i record (risultato, pathname) vengono accumulati in un buffer del thread e inviati
+ *         in un unico frame con una sola writev quando il buffer e' pieno, quando il record piu' vecchio ha
+ *         atteso SENDER_MAX_DELAY ms o quando il worker resta senza lavoro. Con la versione 1 ogni risultato
+ *         viene inviato subito, sempre con una sola writev. Con la versione 3 i record vengono scritti
+ *         direttamente nell'anello in memoria condivisa del worker (shmring.h), senza passare dal socket.
+ *         Con PROTO_INPROC i frame della versione 2 vengono consegnati al collector interno (inproc.h).
+ *         Il limite SENDER_MAX_DELAY vale anche mentre il worker e' occupato in un task lungo: un thread di
+ *         servizio comune a tutti i sender controlla ogni SENDER_TICK ms i record in attesa e invia quelli vicini
+ *         alla scadenza. Ogni sender ha una lock, presa dal worker a ogni record e dal thread di servizio con
+ *         trylock, per cui un worker non attende mai il thread di servizio.
+ */
+
+#ifndef SENDER_H
+#define SENDER_H
+
+// include
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <shmring.h>
+
+#define SENDER_FRAME (32 * 1024) // dimensione del buffer dei record di un frame
+#define SENDER_MAX_DELAY 50      // attesa massima (ms) di un record nel buffer mentre il worker lavora
+#define SENDER_TICK 10           // intervallo (ms) tra due controlli del thread di servizio
+
+/**
+ *  @struct sender_t
+ *  @brief stato dell'invio su una connessione verso il collector
+ *
+ *  @var fd      socket connesso al collector
+ *  @var version versione del protocollo concordata con il collector
+ *  @var buf     record in attesa di essere inviati (versione 2)
+ *  @var len     byte occupati in buf
+ *  @var oldest  istante in cui e' stato accodato il primo record in buf
+ *  @var ring    anello in memoria condivisa (versione 3)
+ *  @var lock    mutua esclusione tra il worker e il thread di servizio
+ *  @var next    sender successivo tra quelli controllati dal thread di servizio
+ */
+typedef struct sender_t
+{
+    int fd;
+    int version;
+    char *buf;
+    size_t len;
+    struct timespec oldest;
+    shmring_t ring;
+    pthread_mutex_t lock;
+    struct sender_t *next;
+} sender_t;
+
+/**
+ * @function senderInit
+ * @brief inizializza l'invio sul socket fd e concorda con il collector la versione del protocollo (al piu' version).
+ *        Con version PROTO_INPROC fd viene ignorato
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int senderInit(sender_t *s, int fd, int version);
+
+/**
+ * @function senderPut
+ * @brief invia (versione 1) o accoda (versione 2) il risultato result del file name
+ * @return 0 in caso di successo, -1 in caso di errore di scrittura
+ */
+int senderPut(sender_t *s, long result, const char *name);
+
+/**
+ * @function senderPending
+ * @return 1 se ci sono record accodati e non ancora inviati, 0 altrimenti
+ */
+int senderPending(sender_t *s);
+
+/**
+ * @function senderFlush
+ * @brief invia in un frame i record accodati; in caso di errore i record vengono scartati
+ * @return 0 in caso di successo, -1 in caso di errore di scrittura
+ */
+int senderFlush(sender_t *s);
+
+/**
+ * @function senderClose
+ * @brief invia i record accodati e libera il buffer e l'anello (il socket resta aperto); da questo momento il
+ *        thread di servizio non controlla piu' il sender
+ */
+void senderClose(sender_t *s);
+
+#endif // SENDER_H
@@ -0,0 +1,57 @@
+/**************************/
+//  header file server.h   /
+/*========================*/
+
+/**
+ * @brief: farm come server di job (--server <socket>). I client (--submit <socket>) si connettono al socket di
+ *         controllo e inviano un job: la directory di lavoro del client seguita da un pathname per riga (file
+ *         regolari o directory da esplorare) e da una riga vuota. Il server risponde con "JOB <id>" e, quando
+ *         tutti i file del job sono stati calcolati, con i risultati del job in ordine crescente, nello stesso
+ *         formato del collector; poi chiude la connessione.
+ *         Ogni connessione viene letta ed esplorata da un proprio thread, per cui un client lento non blocca
+ *         gli altri; un client che non completa il job entro SERVER_REQUEST_MS ms viene scartato.
+ *         I job condividono il threadpool della farm: un thread dispatcher sottomette a turno al piu'
+ *         SERVER_SLICE file di ciascun job attivo, per cui un job grande non ritarda quelli piccoli arrivati
+ *         dopo di lui di piu' di un turno e di una coda del pool. I risultati di ogni job vengono raccolti
+ *         con lo stesso codice del collector (results.h) e non passano dal processo collector; un thread writer
+ *         li invia ai client con scritture non bloccanti, per cui i worker del pool non attendono mai un client.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+// include
+#include <signal.h>
+#include <threadpool.h>
+
+// numero massimo di file di un job sottomessi al pool in un turno del dispatcher
+#define SERVER_SLICE 16
+// attesa massima in ms tra due controlli del flag di terminazione
+#define SERVER_POLL_MS 200
+// tempo massimo in ms concesso a un client per inviare il job (e per ricevere ogni risposta)
+#define SERVER_REQUEST_MS 10000
+
+/**
+ * @function serverRun
+ * @brief accetta job sul socket sockname e li esegue sul threadpool tp finche' *stop non diventa diverso da 0;
+ *        le directory dei job vengono esplorate con nwalker thread. I file dei job gia' sottomessi vengono
+ *        completati quando il chiamante distrugge il threadpool, i loro risultati inviati da serverClose
+ * @return 0 quando stop e' stato settato, -1 in caso di errore ed errno settato
+ */
+int serverRun(threadpool_t *tp, const char *sockname, int nwalker, volatile sig_atomic_t *stop);
+
+/**
+ * @function serverClose
+ * @brief invia ai client i risultati dei job terminati e ferma il writer; va chiamata dopo aver distrutto il
+ *        threadpool passato a serverRun (non fa niente se serverRun non e' stata chiamata o e' fallita)
+ */
+void serverClose(void);
+
+/**
+ * @function serverSubmit
+ * @brief invia al server in ascolto su sockname un job con gli n pathname paths e ne copia la risposta su stdout
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int serverSubmit(const char *sockname, char *paths[], int n);
+
+#endif // SERVER_H
@@ -0,0 +1,122 @@
+/***************************/
+//  header file shmring.h   /
+/*=========================*/
+
+/**
+ * @brief: anello in memoria condivisa con un solo produttore (un thread worker della farm) e un solo consumatore
+ *         (il collector), usato dal protocollo PROTO_V3 (communication.h) al posto del socket per i risultati.
+ *         La regione e' creata dal worker con memfd_create e passata al collector sul socket (SCM_RIGHTS)
+ *         insieme a due eventfd: data (il worker segnala con ringNotify i record pubblicati, a lotti) e space
+ *         (il collector segnala al worker sospeso sull'anello pieno che si e' liberato spazio).
+ *         I record (risultato, lunghezza, pathname) sono scritti dal worker direttamente nell'anello e letti
+ *         dal collector dalla regione mappata, senza copie nel kernel. Le posizioni head e tail sono contatori
+ *         di byte che crescono sempre; ogni record e' allineato a 16 byte e non viene mai spezzato dalla fine
+ *         dell'anello (se non c'e' spazio il worker scrive un record di riempimento con lunghezza -1).
+ *         Per lo spazio, chi pubblica una posizione e poi controlla quella dell'altro lato usa l'ordinamento
+ *         seq_cst, come il threadpool con i contatori dei thread sospesi, per cui non si perdono risvegli.
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+// include
+#include <stddef.h>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#define RING_SIZE (1 << 20) // byte di dati dell'anello di un worker (potenza di 2)
+#define RING_ALIGN 16       // allineamento dei record
+
+/**
+ *  @struct ringhdr_t
+ *  @brief intestazione dell'anello, all'inizio della regione condivisa (i dati seguono)
+ *
+ *  @var size    byte di dati, potenza di 2
+ *  @var head    byte consumati dal collector
+ *  @var tail    byte pubblicati dal worker
+ *  @var waiting 1 se il worker e' (o sta per essere) sospeso sull'eventfd space perche' l'anello e' pieno
+ */
+typedef struct ringhdr_t
+{
+    size_t size;
+    size_t head __attribute__((aligned(CACHE_LINE)));
+    size_t tail __attribute__((aligned(CACHE_LINE)));
+    int waiting __attribute__((aligned(CACHE_LINE)));
+} ringhdr_t;
+
+/**
+ *  @struct shmring_t
+ *  @brief anello mappato nel processo corrente
+ *
+ *  @var hdr     intestazione condivisa
+ *  @var data    inizio dei dati
+ *  @var size    byte di dati (letto dall'intestazione e verificato una volta sola)
+ *  @var notified tail gia' segnalata al collector (lato worker)
+ *  @var mapsize dimensione della mappatura
+ *  @var memfd   descrittore della regione
+ *  @var datafd  eventfd per segnalare dati disponibili (non bloccante)
+ *  @var spacefd eventfd per segnalare spazio disponibile
+ */
+typedef struct shmring_t
+{
+    ringhdr_t *hdr;
+    char *data;
+    size_t size;
+    size_t notified;
+    size_t mapsize;
+    int memfd;
+    int datafd;
+    int spacefd;
+} shmring_t;
+
+/**
+ * @function ringCreate
+ * @brief crea (lato worker) un anello vuoto con RING_SIZE byte di dati e i suoi eventfd
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int ringCreate(shmring_t *r);
+
+/**
+ * @function ringAttach
+ * @brief mappa (lato collector) l'anello ricevuto dal worker; i descrittori passano all'anello
+ * @return 0 in caso di successo, -1 se la regione non e' valida o in caso di errore ed errno settato
+ */
+int ringAttach(shmring_t *r, int memfd, int datafd, int spacefd);
+
+/**
+ * @function ringPut
+ * @brief scrive nell'anello il risultato result del file name, sospendendosi finche' l'anello e' pieno (prima di
+ *        sospendersi segnala i record pubblicati). Il record viene segnalato al collector da ringNotify
+ * @return 0 in caso di successo, -1 in caso di errore
+ */
+int ringPut(shmring_t *r, long result, const char *name);
+
+/**
+ * @function ringUnnotified
+ * @return i byte pubblicati dal worker e non ancora segnalati al collector
+ */
+size_t ringUnnotified(const shmring_t *r);
+
+/**
+ * @function ringNotify
+ * @brief segnala al collector (eventfd data) i record pubblicati dall'ultima segnalazione, se ce ne sono
+ */
+void ringNotify(shmring_t *r);
+
+/**
+ * @function ringDrain
+ * @brief consuma i record pubblicati, chiamando fun(result, name, arg) per ciascuno (name e' valido solo
+ *        durante la chiamata) e azzera il contatore dell'eventfd data
+ * @return il numero di record consumati, -1 se un record non e' valido o fun ha fallito
+ */
+long ringDrain(shmring_t *r, int (*fun)(long result, char *name, void *arg), void *arg);
+
+/**
+ * @function ringDestroy
+ * @brief toglie la mappatura dell'anello e ne chiude i descrittori
+ */
+void ringDestroy(shmring_t *r);
+
+#endif // SHMRING_H
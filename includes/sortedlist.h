@@ -1,69 +1,228 @@
-// Linked List in C Implementation code
-// with a function insertion_sort to insert a node in the list in a sorted way in ascending order
-// using the long data node field as the key to sort
+// Sorted list of the results in C Implementation code, kept in a B+tree
+// with a function insertion_sort to insert a result in the list in a sorted way in ascending order
+// using the long result as the key to sort.
+// The results are stored in the leaves (keys and file names in separate arrays), the leaves are linked
+// from left to right so printList walks them in order; an insertion descends the tree with a binary
+// search in every node, so it costs O(log n) and touches only a few cache lines per level.
+// The nodes come from an arena and the file names are stored back to back in a name store (arena.h):
+// no malloc per result, and the whole list is freed at once
+
+#ifndef SORTEDLIST_H
+#define SORTEDLIST_H
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <arena.h>
+
+#define BTREE_ORDER 64     // max number of keys in a node
+#define BTREE_MAXHEIGHT 16 // enough for 32^16 results
+
+// a leaf: BTREE_ORDER results at most, in ascending order
+struct Leaf
+{
+  int n;                        // number of results in the leaf
+  long keys[BTREE_ORDER];       // results
+  size_t names[BTREE_ORDER];    // offsets of the filenames in the name store
+  struct Leaf *next;            // Pointer pointing towards next leaf
+};
 
-// a node in linked list
-struct Node
+// an inner node: child[i] holds the keys between keys[i-1] and keys[i]
+struct Inner
 {
-  long data;         // result
-  char *file_name;   // filename
-  struct Node *next; // Pointer pointing towards next node
+  int n;                          // number of keys, the node has n + 1 children
+  long keys[BTREE_ORDER];         // separators
+  void *child[BTREE_ORDER + 1];   // inner nodes, or leaves in the lowest level
 };
 
-// function to print the linked list
-void printList(struct Node *node)
+// the list
+struct SortedList
 {
-  while (node != NULL)
+  void *root;         // root node, a leaf if height is 0
+  int height;         // number of inner levels
+  struct Leaf *first; // leftmost leaf (smallest results)
+  size_t size;        // number of results
+  struct Arena nodes; // memory of the nodes
+  struct NameStore names; // filenames
+};
+
+// position of the first key not smaller than key (keys before it are smaller)
+static inline int lowerBound(const long *keys, int n, long key)
+{
+  int lo = 0, hi = n;
+  while (lo < hi)
   {
-    printf("%ld %s \n", node->data, node->file_name);
-    node = node->next;
+    int mid = (lo + hi) / 2;
+    if (keys[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
+  return lo;
 }
 
-// create a new Node with data and file_name fields as the args
-struct Node *newNode(long data, char *filename)
+// create an empty list
+struct SortedList *newList(void)
 {
-  struct Node *newNode = (struct Node *)malloc(sizeof(struct Node));
-  newNode->data = data;
-  newNode->file_name = (char *)malloc(sizeof(char) * (strlen(filename) + 1));
-  strcpy(newNode->file_name, filename);
-  newNode->next = NULL;
-  return newNode;
+  struct SortedList *list = (struct SortedList *)malloc(sizeof(struct SortedList));
+  if (list == NULL)
+    return NULL;
+  arenaInit(&list->nodes);
+  namesInit(&list->names);
+  if ((list->first = (struct Leaf *)arenaAlloc(&list->nodes, sizeof(struct Leaf))) == NULL)
+  {
+    free(list);
+    return NULL;
+  }
+  list->first->n = 0;
+  list->first->next = NULL;
+  list->root = list->first;
+  list->height = 0;
+  list->size = 0;
+  return list;
 }
 
-// function to insert data in sorted position (ascendind order, key is result field)
-void insertion_sort(struct Node **head, struct Node *newNode)
+// function to print the list on out
+void printList(struct SortedList *list, FILE *out)
 {
-  // If linked list is empty or we have to perform an insertion in the head of the list
-  if (*head == NULL || (*head)->data >= newNode->data)
-  { // inserimento in testa
-    newNode->next = *head;
-    *head = newNode;
-    return;
-  }
-
-  // Locate the node before insertion
-  struct Node *current = *head;
-  while (current->next != NULL && current->next->data < newNode->data)
-    current = current->next;
+  for (struct Leaf *leaf = list->first; leaf != NULL; leaf = leaf->next)
+    for (int i = 0; i < leaf->n; i++)
+      fprintf(out, "%ld %s \n", leaf->keys[i], nameAt(&list->names, leaf->names[i]));
+}
 
-  newNode->next = current->next;
-  current->next = newNode;
+// insert (key, child) after position pos of a non full inner node
+static inline void innerInsert(struct Inner *node, int pos, long key, void *child)
+{
+  memmove(&node->keys[pos + 1], &node->keys[pos], sizeof(long) * (node->n - pos));
+  memmove(&node->child[pos + 2], &node->child[pos + 1], sizeof(void *) * (node->n - pos));
+  node->keys[pos] = key;
+  node->child[pos + 1] = child;
+  node->n++;
 }
 
-// function to free the memory allocated for the list
-void free_list(struct Node *head)
+// function to insert a result in sorted position (ascendind order, key is the result), filename is copied.
+// As in the original linked list a result is inserted before the results with the same value.
+// Returns 0 on success, -1 if the memory is exhausted
+int insertion_sort(struct SortedList *list, long data, char *filename)
 {
-  struct Node *current = head;
-  struct Node *next;
-  while (current != NULL)
+  struct Inner *path[BTREE_MAXHEIGHT];
+  int index[BTREE_MAXHEIGHT];
+
+  size_t name = internName(&list->names, filename);
+  if (name == NAMESTORE_NONE)
+    return -1;
+
+  // descend to the leaf, in every node towards the first key not smaller than data
+  void *node = list->root;
+  for (int h = 0; h < list->height; h++)
+  {
+    path[h] = (struct Inner *)node;
+    index[h] = lowerBound(path[h]->keys, path[h]->n, data);
+    node = path[h]->child[index[h]];
+  }
+  struct Leaf *leaf = (struct Leaf *)node;
+  int pos = lowerBound(leaf->keys, leaf->n, data);
+
+  // a full leaf splits, and so does every full ancestor above it (up to a new root): all the nodes are
+  // allocated before the tree is modified, so if the memory is exhausted the tree is left unchanged
+  void *spare[BTREE_MAXHEIGHT + 2];
+  int nspare = 0;
+  if (leaf->n == BTREE_ORDER)
+  {
+    int h = list->height - 1;
+    while (h >= 0 && path[h]->n == BTREE_ORDER)
+      h--;
+    if (h < 0 && list->height == BTREE_MAXHEIGHT)
+      return -1;
+    int needed = list->height - h + (h < 0); // the leaf, the full ancestors and the new root
+    for (int i = 0; i < needed; i++)
+    {
+      size_t size = (i == 0) ? sizeof(struct Leaf) : sizeof(struct Inner);
+      if ((spare[i] = arenaAlloc(&list->nodes, size)) == NULL)
+        return -1; // the nodes already taken stay in the arena until free_list
+    }
+  }
+
+  // full leaf: move the upper half into a new right sibling
+  struct Leaf *right = NULL;
+  if (leaf->n == BTREE_ORDER)
   {
-    next = current->next;     // Save the next node
-    free(current->file_name); // free file_name field memory
-    free(current);            // Free the current node
-    current = next;           // Move to the next node
+    right = (struct Leaf *)spare[nspare++];
+    int half = BTREE_ORDER / 2;
+    right->n = BTREE_ORDER - half;
+    memcpy(right->keys, &leaf->keys[half], sizeof(long) * right->n);
+    memcpy(right->names, &leaf->names[half], sizeof(size_t) * right->n);
+    right->next = leaf->next;
+    leaf->next = right;
+    leaf->n = half;
+    if (pos > half)
+    { // the result goes in the right leaf (never in its first position, the separator does not change)
+      leaf = right;
+      pos -= half;
+    }
+  }
+  memmove(&leaf->keys[pos + 1], &leaf->keys[pos], sizeof(long) * (leaf->n - pos));
+  memmove(&leaf->names[pos + 1], &leaf->names[pos], sizeof(size_t) * (leaf->n - pos));
+  leaf->keys[pos] = data;
+  leaf->names[pos] = name;
+  leaf->n++;
+  list->size++;
+
+  // propagate the split towards the root
+  void *newChild = right;
+  long sep = (right != NULL) ? right->keys[0] : 0;
+  for (int h = list->height - 1; h >= 0 && newChild != NULL; h--)
+  {
+    struct Inner *parent = path[h];
+    if (parent->n < BTREE_ORDER)
+    {
+      innerInsert(parent, index[h], sep, newChild);
+      newChild = NULL;
+      break;
+    }
+    // full inner node: split it around the middle key, which moves up
+    struct Inner *sibling = (struct Inner *)spare[nspare++];
+    long keys[BTREE_ORDER + 1];
+    void *child[BTREE_ORDER + 2];
+    memcpy(keys, parent->keys, sizeof(long) * parent->n);
+    memcpy(child, parent->child, sizeof(void *) * (parent->n + 1));
+    int at = index[h];
+    memmove(&keys[at + 1], &keys[at], sizeof(long) * (parent->n - at));
+    memmove(&child[at + 2], &child[at + 1], sizeof(void *) * (parent->n - at));
+    keys[at] = sep;
+    child[at + 1] = newChild;
+
+    int total = parent->n + 1, mid = total / 2;
+    parent->n = mid;
+    memcpy(parent->keys, keys, sizeof(long) * mid);
+    memcpy(parent->child, child, sizeof(void *) * (mid + 1));
+    sibling->n = total - mid - 1;
+    memcpy(sibling->keys, &keys[mid + 1], sizeof(long) * sibling->n);
+    memcpy(sibling->child, &child[mid + 1], sizeof(void *) * (sibling->n + 1));
+    sep = keys[mid];
+    newChild = sibling;
   }
-}
\ No newline at end of file
+
+  // the root has been split: the tree grows by one level
+  if (newChild != NULL)
+  {
+    struct Inner *root = (struct Inner *)spare[nspare++];
+    root->n = 1;
+    root->keys[0] = sep;
+    root->child[0] = list->root;
+    root->child[1] = newChild;
+    list->root = root;
+    list->height++;
+  }
+  return 0;
+}
+
+// function to free the memory allocated for the list: nodes and filenames are released in one shot
+void free_list(struct SortedList *list)
+{
+  arenaRelease(&list->nodes);
+  namesRelease(&list->names);
+  free(list);
+}
+
+#endif // SORTEDLIST_H
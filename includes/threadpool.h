@@ -22,6 +22,32 @@ typedef struct taskfun_t
     void *arg;
 } taskfun_t;
 
+/**
+ *  @struct taskres_t
+ *  @brief risultato di un task, il suo indirizzo e' il secondo argomento passato a fun
+ *
+ *  @var sum  Risultato della computazione (primo campo, fun lo puo' trattare come un long *)
+ *  @var name Nome con cui il risultato viene inviato al collector, inizialmente coincide con arg.
+ *            Se fun lo sostituisce con un'altra stringa allocata con pathAlloc/pathDup, il pool la libera dopo l'invio
+ */
+typedef struct taskres_t
+{
+    long sum;
+    char *name;
+} taskres_t;
+
+// valori di ritorno di fun
+#define TASK_DONE 0    // risultato pronto, va inviato al collector
+#define TASK_PARTIAL 1 // risultato parziale gia' accumulato altrove, non c'e' niente da inviare
+
+// implementazioni della coda dei task pendenti
+#define POOL_QUEUE_MUTEX 0    // coda circolare protetta da lock con variabili di condizione
+#define POOL_QUEUE_LOCKFREE 1 // coda circolare lock-free (lfqueue.h), i worker si sospendono dopo uno spin adattivo
+#define POOL_QUEUE_STEALING 2 // una deque per worker (wsdeque.h), i worker inattivi rubano task agli altri
+
+struct lfqueue_t;
+struct wsdeque_t;
+
 /**
  *  @struct threadpool_t
  *  @brief Rappresentazione dell'oggetto threadpool
@@ -37,13 +63,22 @@ typedef struct threadpool_t
     int queue_size;               // massima size della coda, puo' essere anche -1 ad indicare che non si vogliono gestire task pendenti
     int taskonthefly;             // numero di task attualmente in esecuzione
     int head, tail;               // riferimenti della coda
-    int count;                    // numero di task nella coda dei task pendenti
+    int count;                    // numero di task nella coda dei task pendenti (con POOL_QUEUE_STEALING in tutte le deque)
     int exiting;                  // se > 0 e' iniziato il protocollo di uscita, se 1 il thread aspetta che non ci siano piu' lavori in coda
+    int queue_type;               // implementazione della coda dei task pendenti (POOL_QUEUE_*)
+    int protocol;                 // versione massima del protocollo verso il collector (PROTO_V*, communication.h)
+    struct lfqueue_t *lfq;        // coda lock-free, usata al posto di pending_queue con POOL_QUEUE_LOCKFREE
+    struct wsdeque_t *deques;     // deque dei worker, usate al posto di pending_queue con POOL_QUEUE_STEALING
+    int ndeques;                  // numero di deque inizializzate
+    int next_deque;               // prossima deque (round-robin) per i task sottomessi da thread esterni al pool
+    int inflight;                 // produttori che stanno inserendo nella coda lock-free
+    int sleeping_consumers;       // worker sospesi su cond_consumer (coda lock-free)
+    int sleeping_producers;       // produttori sospesi su cond_producer (coda lock-free)
 } threadpool_t;
 
 /**
  * @function createThreadPool
- * @brief Crea un oggetto thread pool.
+ * @brief Crea un oggetto thread pool con la coda dei task pendenti protetta da mutex.
  * @param numthreads è il numero di thread del pool
  * @param pending_size è la size delle richieste che possono essere pendenti. Questo parametro è 0 se si vuole utilizzare un modello per il pool con 1 thread 1 richiesta, cioe' non ci sono richieste pendenti.
  *
@@ -51,6 +86,31 @@ typedef struct threadpool_t
  */
 threadpool_t *createThreadPool(int numthreads, int pending_size);
 
+/**
+ * @function createThreadPoolWithQueue
+ * @brief Crea un oggetto thread pool scegliendo l'implementazione della coda dei task pendenti.
+ * @param numthreads è il numero di thread del pool
+ * @param pending_size è la size delle richieste che possono essere pendenti (vedi createThreadPool)
+ * @param queue_type POOL_QUEUE_MUTEX, POOL_QUEUE_LOCKFREE oppure POOL_QUEUE_STEALING
+ *
+ * @return un nuovo thread pool oppure NULL ed errno settato opportunamente
+ */
+threadpool_t *createThreadPoolWithQueue(int numthreads, int pending_size, int queue_type);
+
+/**
+ * @function createThreadPoolWithProtocol
+ * @brief Crea un oggetto thread pool scegliendo la coda dei task pendenti e il protocollo verso il collector
+ *        (createThreadPoolWithQueue usa PROTO_V2).
+ * @param numthreads è il numero di thread del pool
+ * @param pending_size è la size delle richieste che possono essere pendenti (vedi createThreadPool)
+ * @param queue_type POOL_QUEUE_MUTEX, POOL_QUEUE_LOCKFREE oppure POOL_QUEUE_STEALING
+ * @param protocol PROTO_V1 (un messaggio per risultato), PROTO_V2 (frame di risultati) oppure PROTO_V3
+ *                 (anello in memoria condivisa), PROTO_INPROC per il collector interno alla farm (inproc.h)
+ *
+ * @return un nuovo thread pool oppure NULL ed errno settato opportunamente
+ */
+threadpool_t *createThreadPoolWithProtocol(int numthreads, int pending_size, int queue_type, int protocol);
+
 /**
  * @function destroyThreadPool
  * @brief stoppa tutti i thread e distrugge l'oggetto pool
@@ -71,4 +131,40 @@ int destroyThreadPool(threadpool_t *pool, int force);
  */
 int addToThreadPool(threadpool_t *pool, int (*fun)(void *, void*), void *arg);
 
+/**
+ * @function addTaskToThreadPool
+ * @brief aggiunge un task al pool senza copiarne l'argomento
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per eseguire il task
+ * @param arg  argomento della funzione allocato con pathAlloc/pathDup (pathalloc.h), in caso di successo passa al pool che lo libera dopo l'esecuzione del task
+ * @return 0 se successo, 1 se non ci sono thread disponibili e/o la coda è piena, -1 in caso di fallimento, errno viene settato opportunamente.
+ *         Se il valore di ritorno e' diverso da 0 arg resta al chiamante.
+ */
+int addTaskToThreadPool(threadpool_t *pool, int (*fun)(void *, void *), void *arg);
+
+/**
+ * @function addManyToThreadPool
+ * @brief aggiunge al pool un lotto di task, copiandone gli argomenti come addToThreadPool
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per ciascun task
+ * @param args argomenti delle funzioni (pathname dei file su cui si deve lavorare)
+ * @param n    numero di task del lotto
+ * @return il numero di task aggiunti (i primi del lotto, meno di n se il pool e' in uscita o non ci sono thread disponibili),
+ *         -1 in caso di fallimento, errno viene settato opportunamente.
+ */
+int addManyToThreadPool(threadpool_t *pool, int (*fun)(void *, void *), void *args[], int n);
+
+/**
+ * @function addManyTasksToThreadPool
+ * @brief aggiunge al pool un lotto di task senza copiarne gli argomenti, con una sola acquisizione del lock e un solo
+ *        risveglio dei worker (backend POOL_QUEUE_MUTEX)
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per ciascun task
+ * @param args argomenti allocati con pathAlloc/pathDup, quelli dei task aggiunti passano al pool
+ * @param n    numero di task del lotto
+ * @return il numero di task aggiunti (i primi del lotto), -1 in caso di fallimento, errno viene settato opportunamente.
+ *         Gli argomenti dei task non aggiunti restano al chiamante.
+ */
+int addManyTasksToThreadPool(threadpool_t *pool, int (*fun)(void *, void *), void *args[], int n);
+
 #endif /* THREADPOOL_H_ */
@@ -0,0 +1,49 @@
+/**************************/
+//  header file walker.h   /
+/*========================*/
+
+/**
+ * @brief: esplorazione parallela di un albero di directory. Un gruppo di thread di esplorazione estrae le
+ *         directory da una coda condivisa, le legge con fdopendir e vi inserisce le sottodirectory trovate
+ *         (aperte con openat relativamente alla directory che le contiene). Per ogni file regolare viene
+ *         chiamata la callback file; la stat (fstatat relativa alla directory) viene fatta solo se d_type
+ *         non basta a riconoscere il tipo dell'entry o se il chiamante ha bisogno della dimensione dei file.
+ */
+
+#ifndef WALKER_H
+#define WALKER_H
+
+// include
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ *  @struct walker_ops_t
+ *  @brief callback e parametri dell'esplorazione
+ *
+ *  @var file      chiamata (anche in parallelo da thread diversi) per ogni file regolare con il suo pathname e il
+ *                 risultato della stat, NULL se need_stat e' 0 e la stat non e' stata necessaria
+ *  @var dir_done  chiamata dal thread che ha finito di leggere una directory, puo' essere NULL
+ *  @var arg       argomento passato alle callback
+ *  @var need_stat se diverso da 0 la callback file riceve sempre il risultato della stat
+ *  @var stop      se diventa diverso da 0 l'esplorazione termina il prima possibile, puo' essere NULL
+ */
+typedef struct walker_ops_t
+{
+    int (*file)(const char *path, const struct stat *st, void *arg);
+    void (*dir_done)(void *arg);
+    void *arg;
+    int need_stat;
+    volatile sig_atomic_t *stop;
+} walker_ops_t;
+
+/**
+ * @function walkTree
+ * @brief esplora l'albero con radice root usando nthreads thread e ritorna quando l'esplorazione e' completa.
+ *        Gli errori sulle singole entry vengono stampati e le entry saltate
+ * @return 0 in caso di successo, -1 se non e' stato possibile avviare l'esplorazione ed errno settato
+ */
+int walkTree(const char *root, int nthreads, const walker_ops_t *ops);
+
+#endif // WALKER_H
@@ -0,0 +1,47 @@
+/**************************/
+//  header file watch.h    /
+/*========================*/
+
+/**
+ * @brief: osservazione continua di un albero di directory con inotify (--watch). Ogni directory dell'albero,
+ *         comprese quelle create dopo l'avvio, ha un watch per IN_CLOSE_WRITE e IN_MOVED_TO: un file regolare
+ *         scritto e chiuso oppure spostato nell'albero viene passato alla callback file, con la sua stat.
+ *         Quando viene creata una sottodirectory i file che contiene gia' vengono passati alla callback subito
+ *         dopo averla osservata, per non perdere quelli creati prima che il watch esistesse.
+ *         Le callback sono le stesse dell'esplorazione (walker.h): dir_done viene chiamata dopo ogni lettura
+ *         degli eventi pendenti.
+ */
+
+#ifndef WATCH_H
+#define WATCH_H
+
+// include
+#include <walker.h>
+
+// attesa massima in ms tra due controlli del flag di terminazione
+#define WATCH_POLL_MS 200
+
+typedef struct watcher_t watcher_t;
+
+/**
+ * @function watchCreate
+ * @brief osserva l'albero con radice root; va chiamata prima di esplorarlo, cosi' i file creati durante
+ *        l'esplorazione non vengono persi (possono pero' essere passati due volte alla callback)
+ * @return l'osservatore oppure NULL in caso di errore ed errno settato
+ */
+watcher_t *watchCreate(const char *root);
+
+/**
+ * @function watchRun
+ * @brief passa alle callback di ops i file scritti o spostati nell'albero finche' *ops->stop non diventa diverso da 0
+ * @return 0 quando ops->stop e' stato settato, -1 in caso di errore ed errno settato
+ */
+int watchRun(watcher_t *w, const walker_ops_t *ops);
+
+/**
+ * @function watchDestroy
+ * @brief smette di osservare l'albero e libera le risorse
+ */
+void watchDestroy(watcher_t *w);
+
+#endif // WATCH_H
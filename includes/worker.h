@@ -8,22 +8,112 @@
  * passato come argomento alla funzione.
  */
 
+#ifndef WORKER_H
+#define WORKER_H
+
 // include
 #include <stdio.h>
+#include <pthread.h>
 #include <threadpool.h>
+#include <rcache.h>
 
 /**
  * @brief: la funzione compute implementa il lavoro che un thread worker deve compiere,
  *         la funzione prende in ingresso il pathname di un file regolare, il file viene interpretato
- *         come un file binario contenente N long, i long contenuti nel file vengono letti uno ad uno e viene
- *         eseguita una computazione. Il calcolo che deve essere effettuato su ogni file è il seguente:
+ *         come un file binario contenente N long, il file viene mappato in memoria (con fallback su read a blocchi
+ *         se non e' mappabile) e sui long contenuti viene eseguita una computazione. Il calcolo che deve essere effettuato su ogni file è il seguente:
  *         result = sommatoria (per i che va da 0 a N-1) di (i * file[i])
  *         N è il numero di long presenti nel file e file[i] è l' i-esimo long
  *         Se la computazione è stata eseguita con successo il risultato viene memorizzato nella variabile puntata
- *         dall' argomento result.
+ *         dall' argomento result e, se la cache dei risultati e' aperta, anche nella cache (rcache.h).
+ *         In modalita' incrementale, se la cache contiene il risultato di un prefisso del file, vengono letti
+ *         solo i long successivi al prefisso.
  * @param file_name --> pathname del file su cui operare
  * @param result --> puntatore a long dove memorizzare il risultato della computazione
  * @return: 0 (int) se la funzione è stata eseguita con successo e  il risultato della computazione nella variabile puntata da result
  *         -1 altrimenti;
  */
-int compute(char *file_name, long *result);
\ No newline at end of file
+int compute(char *file_name, long *result);
+
+/**
+ * @brief: task per i file letti da un elenco (--files-from) senza averne fatto la stat: come compute, ma un
+ *         pathname che non esiste, non e' leggibile o non e' un file regolare viene segnalato e scartato
+ * @param file_name --> pathname del file
+ * @param res --> riceve il risultato
+ * @return: TASK_DONE se il risultato va inviato al collector, TASK_PARTIAL se il file e' stato scartato
+ */
+int compute_listed(char *file_name, taskres_t *res);
+
+/**
+ *  @struct chunkjob_t
+ *  @brief file suddiviso in chunk calcolati in parallelo da piu' worker.
+ *         Il chunk a offset k contribuisce sommatoria di (k + j) * x[j], per cui il risultato del file
+ *         e' la somma dei risultati dei chunk; l'ultimo chunk che termina restituisce il risultato complessivo.
+ *
+ *  @var file_name pathname del file
+ *  @var lock      mutua esclusione nell'accesso a sum, pending e cancelled
+ *  @var sum       somma dei risultati parziali (unsigned per avere la semantica wraparound)
+ *  @var pending   numero di chunk non ancora terminati
+ *  @var cancelled 1 se almeno un chunk e' fallito o non e' stato sottomesso, il file viene scartato
+ *  @var key       chiave del file nella cache dei risultati (rcache.h)
+ *  @var check     controllo degli ultimi long del file per la cache, scritto dal chunk che li contiene
+ */
+typedef struct chunkjob_t
+{
+    char *file_name;
+    pthread_mutex_t lock;
+    unsigned long sum;
+    long pending;
+    int cancelled;
+    rckey_t key;
+    unsigned long check;
+} chunkjob_t;
+
+/**
+ *  @struct chunk_t
+ *  @brief argomento di un task compute_chunk: l'intervallo di long [first, first + count) di un file
+ */
+typedef struct chunk_t
+{
+    chunkjob_t *job;
+    long first;
+    long count;
+} chunk_t;
+
+/**
+ * @brief: crea un job per un file che verra' suddiviso in nchunks chunk, st e' il risultato della sua stat
+ * @return il job oppure NULL in caso di errore (errno settato)
+ */
+chunkjob_t *newChunkJob(const char *file_name, const struct stat *st, long nchunks);
+
+/**
+ * @brief: segnala al job che nchunks chunk non verranno mai eseguiti (ad esempio perche' il threadpool
+ *         non li ha accettati): il file viene scartato e il job liberato quando non ci sono piu' chunk pendenti
+ */
+void cancelChunks(chunkjob_t *job, long nchunks);
+
+/**
+ * @brief: task che calcola un chunk di un file e accumula il risultato parziale nel job.
+ * @param chunk --> chunk da calcolare (liberato dal pool dopo l'esecuzione)
+ * @param res --> se il chunk e' l'ultimo del job riceve il risultato complessivo e il pathname del file
+ * @return: TASK_DONE se il chunk e' l'ultimo e res va inviato al collector, TASK_PARTIAL se non c'e'
+ *          niente da inviare (anche se il chunk non e' stato letto: il file viene scartato)
+ */
+int compute_chunk(chunk_t *chunk, taskres_t *res);
+
+/**
+ * @brief: crea l'argomento di un task cached_result per il file file_name, il cui risultato result e' stato
+ *         trovato nella cache: il pathname seguito dal risultato, in un blocco allocato con pathAlloc
+ * @return l'argomento oppure NULL in caso di errore (errno settato)
+ */
+char *newCachedTask(const char *file_name, long result);
+
+/**
+ * @brief: task che invia al collector un risultato trovato nella cache senza leggere il file
+ * @param arg --> argomento creato con newCachedTask
+ * @param res --> riceve il risultato, il nome e' quello del file
+ * @return: TASK_DONE
+ */
+int cached_result(char *arg, taskres_t *res);
+
+#endif // WORKER_H
@@ -0,0 +1,74 @@
+/***************************/
+//  header file wsdeque.h   /
+/*=========================*/
+
+/**
+ * @brief: deque di task usata dal threadpool con backend POOL_QUEUE_STEALING. Ogni worker possiede
+ *         una deque: il proprietario inserisce ed estrae dal fondo (bottom, ordine LIFO, i sottotask
+ *         appena creati restano "caldi" in cache), i worker inattivi rubano dalla cima (top, i task piu'
+ *         vecchi). Ogni deque ha il proprio lock, per cui produttori e worker si contendono solo la deque
+ *         che stanno usando e non c'e' piu' un unico punto di serializzazione.
+ */
+
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+// include
+#include <stddef.h>
+#include <pthread.h>
+#include <threadpool.h>
+
+/**
+ *  @struct wsdeque_t
+ *  @brief deque circolare che si espande quando e' piena
+ *
+ *  @var lock   mutua esclusione nell'accesso alla deque
+ *  @var buf    array circolare dei task
+ *  @var cap    capacita' di buf (potenza di 2)
+ *  @var top    posizione del task piu' vecchio (estremo da cui rubano gli altri worker)
+ *  @var bottom posizione successiva al task piu' recente (estremo del proprietario)
+ */
+typedef struct wsdeque_t
+{
+    pthread_mutex_t lock;
+    taskfun_t *buf;
+    size_t cap;
+    size_t top;
+    size_t bottom;
+} wsdeque_t;
+
+/**
+ * @function wsdInit
+ * @brief inizializza una deque vuota
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int wsdInit(wsdeque_t *d);
+
+/**
+ * @function wsdPush
+ * @brief inserisce un task sul fondo della deque
+ * @return 0 in caso di successo, -1 in caso di errore ed errno settato
+ */
+int wsdPush(wsdeque_t *d, const taskfun_t *task);
+
+/**
+ * @function wsdPop
+ * @brief estrae il task piu' recente (usata dal proprietario)
+ * @return 0 in caso di successo, -1 se la deque e' vuota
+ */
+int wsdPop(wsdeque_t *d, taskfun_t *task);
+
+/**
+ * @function wsdSteal
+ * @brief estrae il task piu' vecchio (usata dagli altri worker)
+ * @return 0 in caso di successo, -1 se la deque e' vuota
+ */
+int wsdSteal(wsdeque_t *d, taskfun_t *task);
+
+/**
+ * @function wsdDestroy
+ * @brief libera le risorse della deque (i task eventualmente presenti non vengono liberati)
+ */
+void wsdDestroy(wsdeque_t *d);
+
+#endif // WSDEQUE_H
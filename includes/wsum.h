@@ -0,0 +1,42 @@
+/**************************/
+//  header file wsum.h     /
+/*========================*/
+
+/**
+ * @brief: questo header file contiene il kernel di calcolo della somma pesata
+ *         result = sommatoria (per j che va da 0 a n-1) di ((first + j) * v[j])
+ *         in versione scalare (riferimento) e vettorizzata (SSE2, AVX2, AVX-512).
+ *         La variante da usare viene scelta a runtime da wsum_init in base alle capacita' della CPU.
+ *         Tutte le varianti hanno la semantica wraparound a 64 bit della versione scalare.
+ */
+
+#ifndef WSUM_H
+#define WSUM_H
+
+// include
+#include <stddef.h>
+
+/**
+ * @brief: puntatore alla variante del kernel selezionata (inizialmente la versione scalare)
+ * @param v puntatore al primo long da considerare
+ * @param n numero di long da considerare
+ * @param first indice (nel file) del long puntato da v
+ * @return la somma pesata
+ */
+extern long (*wsum)(const long *v, size_t n, long first);
+
+/**
+ * @brief: sceglie la variante del kernel piu' veloce supportata dalla CPU (__builtin_cpu_supports).
+ *         La variabile d'ambiente FARM_WSUM (scalar, sse2, avx2, avx512) permette di forzare una variante,
+ *         se la variante richiesta non e' supportata viene stampato un warning e si usa quella di default.
+ * @return il nome della variante selezionata
+ */
+const char *wsum_init(void);
+
+// singole varianti del kernel
+long wsum_scalar(const long *v, size_t n, long first);
+long wsum_sse2(const long *v, size_t n, long first);
+long wsum_avx2(const long *v, size_t n, long first);
+long wsum_avx512(const long *v, size_t n, long first);
+
+#endif // WSUM_H
@@ -0,0 +1,122 @@
+/*****************************************************************************************/
+/** Progetto Farm
+ * Laboratorio di sistemi Operativi
+ * @author Andrea Lepori
+ * @file : benchlist.c
+ * @brief : benchmark della lista ordinata del collector: inserisce N risultati con chiavi pseudo-casuali
+ *          (con molti duplicati), ne misura il tempo e verifica l'ordinamento e l'ordine tra chiavi uguali
+ *          (il risultato inserito per ultimo precede gli altri). Con -a misura invece l'array della modalita'
+ *          append del collector, ordinato a meta' e alla fine degli inserimenti come farebbe una stampa con
+ *          SIGUSR1. Uso: ./benchlist [-a] [N], default 10000000
+ */
+/*=======================================================================================*/
+
+#define _POSIX_C_SOURCE 200112L
+
+// include
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sortedlist.h>
+#include <resultarray.h>
+#include <string.h>
+
+#define NINSERT 10000000L
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int append = (argc > 1 && strcmp(argv[1], "-a") == 0);
+    if (append)
+    {
+        argc--;
+        argv++;
+    }
+    long n = (argc > 1) ? strtol(argv[1], NULL, 10) : NINSERT;
+    if (n <= 0)
+    {
+        fprintf(stderr, "usage: %s [-a] [numero_inserimenti]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct SortedList *list = NULL;
+    struct ResultArray *array = NULL;
+    if ((append && (array = newArray()) == NULL) || (!append && (list = newList()) == NULL))
+    {
+        perror("newList");
+        return EXIT_FAILURE;
+    }
+
+    // le chiavi vengono da un xorshift e cadono in n/4 valori diversi, cosi' ci sono molte chiavi uguali;
+    // il nome del file contiene il numero d'ordine dell'inserimento per verificare l'ordine tra chiavi uguali
+    unsigned long x = 88172645463325252UL;
+    long range = (n / 4 > 0) ? n / 4 : 1;
+    char name[32];
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        snprintf(name, sizeof(name), "%ld", i);
+        long key = (long)(x % range) - range / 2;
+        if ((append ? appendResult(array, key, name) : insertion_sort(list, key, name)) == -1)
+        {
+            perror("insertion_sort");
+            return EXIT_FAILURE;
+        }
+        // a meta' una stampa intermedia: la seconda meta' viene poi fusa con la prima gia' ordinata
+        if (append && i == n / 2 && sortArray(array) == -1)
+        {
+            perror("sortArray");
+            return EXIT_FAILURE;
+        }
+    }
+    if (append && sortArray(array) == -1)
+    {
+        perror("sortArray");
+        return EXIT_FAILURE;
+    }
+    double elapsed = now() - start;
+
+    long count = 0, errors = 0;
+    long prev_key = 0, prev_seq = 0;
+    if (append)
+        for (size_t i = 0; i < array->n; i++, count++)
+        {
+            long seq = atol(nameAt(&array->store, array->names[i]));
+            if (count > 0 && (prev_key > array->keys[i] || (prev_key == array->keys[i] && prev_seq < seq)))
+                errors++;
+            prev_key = array->keys[i];
+            prev_seq = seq;
+        }
+    else
+        for (struct Leaf *leaf = list->first; leaf != NULL; leaf = leaf->next)
+            for (int i = 0; i < leaf->n; i++, count++)
+            {
+                long seq = atol(nameAt(&list->names, leaf->names[i]));
+                if (count > 0 && (prev_key > leaf->keys[i] || (prev_key == leaf->keys[i] && prev_seq < seq)))
+                    errors++;
+                prev_key = leaf->keys[i];
+                prev_seq = seq;
+            }
+
+    printf("%ld inserimenti in %.2f s (%.0f ns per inserimento)\n", n, elapsed, elapsed * 1e9 / n);
+    if (append)
+        free_array(array);
+    else
+        free_list(list);
+
+    if (count != n || errors != 0)
+    {
+        fprintf(stderr, "lista non ordinata: %ld nodi, %ld errori\n", count, errors);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
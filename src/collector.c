@@ -3,37 +3,450 @@
  * Laboratorio di sistemi Operativi
  * @author Andrea Lepori
  * @file : collector.c
- * @brief :
+ * @brief : riceve i risultati dai worker e li stampa in ordine crescente. Con l'opzione -a i risultati vengono
+ *          accodati in un array e ordinati solo quando vanno stampati, invece di essere inseriti uno per uno
+ *          nella lista ordinata. I worker che usano la versione 3 del protocollo scrivono i risultati in un
+ *          anello in memoria condivisa: il suo eventfd e' registrato in epoll accanto al socket
  */
 /*=======================================================================================*/
 
 // include
 #include <util.h>
 #include <communication.h>
-#include <sortedlist.h>
-
-/*
-This function iterates through file descriptors from 0 to FD_SETSIZE - 1 and checks if each file descriptor
-is set in the given fd_set. If it is set and greater than the current max_fd, max_fd is updated with the new value.
-Finally, the function returns the maximum file descriptor found. Remember that FD_SETSIZE is a constant
-representing the maximum number of file descriptors that can be stored in an fd_set.
-*/
-int aggiorna(fd_set *set)
+#include <results.h>
+#include <shmring.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+
+// numero massimo di eventi restituiti da una epoll_wait
+#define MAX_EVENTS 64
+// dimensione iniziale del buffer di ricezione di una connessione
+#define RECV_BUF 4096
+// numero massimo di read su una connessione per ogni risveglio, le altre connessioni pronte non aspettano oltre
+#define MAX_READS 16
+
+// stato del parser di una connessione: campo del messaggio che si sta aspettando
+typedef enum
 {
-    int max_fd = -1; // Initialize max_fd to an invalid value
+    RD_CODE,   // codice del comando
+    RD_RESULT, // risultato (codice 0)
+    RD_LENGTH, // lunghezza del pathname (codice 0)
+    RD_NAME,   // pathname terminato da '\0' (codice 0)
+    RD_HELLO,  // versione richiesta dal worker (codice 3)
+    RD_FRAME   // lunghezza e contenuto di un frame di risultati (codice 4)
+} rdstate_t;
+
+// tipo dell'oggetto puntato da data.ptr in un evento epoll (il listener ha data.ptr NULL)
+typedef enum
+{
+    EV_SOCKET, // socket di una connessione (conn_t)
+    EV_RING    // eventfd dell'anello di una connessione (ringsrc_t)
+} evkind_t;
+
+struct conn_t;
+
+/**
+ *  @struct ringsrc_t
+ *  @brief sorgente epoll dell'anello di una connessione
+ *
+ *  @var kind sempre EV_RING
+ *  @var conn connessione che possiede l'anello
+ */
+typedef struct ringsrc_t
+{
+    evkind_t kind;
+    struct conn_t *conn;
+} ringsrc_t;
+
+/**
+ *  @struct conn_t
+ *  @brief stato di una connessione, registrato come data.ptr nell'evento epoll del suo descrittore
+ *
+ *  @var kind   sempre EV_SOCKET
+ *
+ *  @var fd     descrittore del socket della connessione (non bloccante)
+ *  @var state  campo atteso dal parser
+ *  @var result risultato del messaggio in corso
+ *  @var length lunghezza del pathname o del frame del messaggio in corso (-1 se non ancora letta)
+ *  @var buf    buffer di ricezione
+ *  @var cap    capacita' di buf
+ *  @var len    byte ricevuti in buf
+ *  @var pos    byte di buf gia' consumati dal parser
+ *  @var fds    descrittori ricevuti con SCM_RIGHTS e non ancora usati
+ *  @var nfds   numero di descrittori in fds
+ *  @var ring   anello in memoria condivisa (ring.hdr NULL se la connessione non lo usa)
+ *  @var ringev sorgente epoll dell'eventfd dell'anello
+ *  @var next   connessioni chiuse in attesa di essere liberate
+ */
+typedef struct conn_t
+{
+    evkind_t kind;
+    int fd;
+    rdstate_t state;
+    long result;
+    long length;
+    char *buf;
+    size_t cap;
+    size_t len;
+    size_t pos;
+    int fds[RING_FDS];
+    int nfds;
+    shmring_t ring;
+    ringsrc_t ringev;
+    struct conn_t *next;
+} conn_t;
+
+// descrittore epoll
+static int epfd = -1;
+
+// connessioni chiuse durante la gestione degli eventi di una epoll_wait: vengono liberate solo dopo, perche'
+// tra gli eventi gia' restituiti potrebbe esserci anche quello del loro anello
+static conn_t *closed_conns = NULL;
+
+// memorizza un risultato letto dall'anello di una connessione (callback di ringDrain)
+static int store_ring(long result, char *filename, void *res)
+{
+    return resultsStore((results_t *)res, result, filename);
+}
 
-    for (int i = 0; i < FD_SETSIZE; ++i)
+// rende non bloccante il descrittore fd
+static int set_nonblock(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1)
+        return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * funzione add_conns
+ * @brief accetta tutte le connessioni in attesa sul listener (non bloccante) e le registra in epoll
+ * @return il numero di connessioni accettate, -1 in caso di errore
+ */
+static int add_conns(int listenfd)
+{
+    int accepted = 0;
+    for (;;)
     {
-        if (FD_ISSET(i, set))
+        int connfd;
+        if ((connfd = accept(listenfd, (struct sockaddr *)NULL, NULL)) == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                return accepted;
+            perror("accept");
+            return -1;
+        }
+        conn_t *c = malloc(sizeof(conn_t));
+        if (c == NULL || (c->buf = malloc(RECV_BUF)) == NULL || set_nonblock(connfd) == -1)
+        {
+            perror("add_conns");
+            close(connfd);
+            if (c != NULL)
+                free(c->buf);
+            free(c);
+            return -1;
+        }
+        c->kind = EV_SOCKET;
+        c->fd = connfd;
+        c->nfds = 0;
+        c->ring.hdr = NULL;
+        c->state = RD_CODE;
+        c->cap = RECV_BUF;
+        c->len = c->pos = 0;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev) == -1)
         {
-            if (i > max_fd)
+            perror("epoll_ctl");
+            close(connfd);
+            free(c->buf);
+            free(c);
+            return -1;
+        }
+        // printf("Connection opened by client on socket %d\n", connfd);
+        accepted++;
+    }
+}
+
+/**
+ * funzione close_conn
+ * @brief chiude una connessione (la close la rimuove anche da epoll) dopo aver consumato quello che resta nel
+ *        suo anello; lo stato viene liberato da free_closed
+ */
+static void close_conn(conn_t *c, results_t *res)
+{
+    // printf("Connection closed by client on socket %d\n", c->fd);
+    if (c->len > c->pos || c->state != RD_CODE)
+        fprintf(stderr, "collector: connessione %d chiusa con un messaggio incompleto\n", c->fd);
+    if (c->ring.hdr != NULL)
+    { // il worker ha pubblicato tutti i suoi risultati prima di chiudere il socket
+        if (ringDrain(&c->ring, store_ring, res) == -1)
+            fprintf(stderr, "collector: anello non valido sulla connessione %d\n", c->fd);
+        // l'eventfd e' aperto anche nel worker: la close non basta a toglierlo da epoll
+        epoll_ctl(epfd, EPOLL_CTL_DEL, c->ring.datafd, NULL);
+        ringDestroy(&c->ring);
+    }
+    for (int i = 0; i < c->nfds; i++)
+        close(c->fds[i]);
+    c->nfds = 0;
+    close(c->fd);
+    c->fd = -1;
+    c->next = closed_conns;
+    closed_conns = c;
+}
+
+// libera le connessioni chiuse
+static void free_closed(void)
+{
+    while (closed_conns != NULL)
+    {
+        conn_t *c = closed_conns;
+        closed_conns = c->next;
+        free(c->buf);
+        free(c);
+    }
+}
+
+/**
+ * funzione attach_ring
+ * @brief mappa l'anello i cui descrittori sono arrivati con MSG_RING e ne registra l'eventfd in epoll
+ * @return 0 se la connessione usera' l'anello, -1 altrimenti
+ */
+static int attach_ring(conn_t *c)
+{
+    if (c->nfds != RING_FDS || c->ring.hdr != NULL)
+        return -1;
+    c->nfds = 0; // i descrittori passano all'anello, anche se ringAttach fallisce
+    if (ringAttach(&c->ring, c->fds[0], c->fds[1], c->fds[2]) == -1)
+    {
+        perror("ringAttach");
+        return -1;
+    }
+    c->ringev.kind = EV_RING;
+    c->ringev.conn = c;
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &c->ringev;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, c->ring.datafd, &ev) == -1)
+    {
+        perror("epoll_ctl");
+        ringDestroy(&c->ring);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * funzione parse
+ * @brief consuma tutti i messaggi completi presenti nel buffer della connessione: inserisce in lista i
+ *        risultati (codice 0 o frame con codice 4), stampa la lista (codice 1), segnala la terminazione
+ *        (codice 2), risponde all'handshake della versione (codice 3)
+ * @return 0 in caso di successo, -1 se il messaggio non rispetta il protocollo
+ */
+static int parse(conn_t *c, results_t *res, int *termina)
+{
+    long codice;
+    for (;;)
+    {
+        size_t avail = c->len - c->pos;
+        char *p = c->buf + c->pos;
+        switch (c->state)
+        {
+        case RD_CODE:
+            if (avail < sizeof(long))
+                return 0;
+            memcpy(&codice, p, sizeof(long));
+            c->pos += sizeof(long);
+            // printf("codice : %ld\n", codice);
+            if (codice == MSG_EXIT)
+                *termina = 1; // se il codice indica la terminazione metto termina a 1
+            else if (codice == MSG_PRINT)
+            { //  codice 1 --> stampo la lista
+                resultsPrint(res);
+            }
+            else if (codice == MSG_RESULT)
+                c->state = RD_RESULT; // codice 0 --> inserimento nella lista
+            else if (codice == MSG_HELLO)
+                c->state = RD_HELLO;
+            else if (codice == MSG_FRAME)
+            {
+                c->state = RD_FRAME;
+                c->length = -1;
+            }
+            else if (codice == MSG_RING)
+            { // rispondo con la versione con cui il worker inviera' i risultati
+                long accepted = (attach_ring(c) == 0) ? PROTO_V3 : PROTO_V2;
+                if (write(c->fd, &accepted, sizeof(long)) != sizeof(long))
+                    return -1;
+            }
+            else
+                return -1;
+            break;
+        case RD_RESULT:
+            if (avail < sizeof(long))
+                return 0;
+            memcpy(&c->result, p, sizeof(long));
+            c->pos += sizeof(long);
+            c->state = RD_LENGTH;
+            break;
+        case RD_LENGTH:
+            if (avail < sizeof(long))
+                return 0;
+            memcpy(&c->length, p, sizeof(long));
+            c->pos += sizeof(long);
+            if (c->length <= 0 || c->length > PATH_MAX)
+                return -1;
+            c->state = RD_NAME;
+            break;
+        case RD_NAME:
+            if (avail < (size_t)c->length)
+                return 0;
+            p[c->length - 1] = '\0';
+            // memorizzo il risultato
+            if (resultsStore(res, c->result, p) == -1)
             {
-                max_fd = i; // Update max_fd if the current FD is greater
+                perror("resultsStore");
+                return -1;
+            }
+            c->pos += c->length;
+            c->state = RD_CODE;
+            break;
+        case RD_HELLO:
+        {
+            if (avail < sizeof(long))
+                return 0;
+            long version;
+            memcpy(&version, p, sizeof(long));
+            c->pos += sizeof(long);
+            if (version < PROTO_V1)
+                return -1;
+            // rispondo con la versione piu' alta supportata da entrambi (la connessione e' appena aperta, la
+            // risposta entra comunque nel buffer del socket)
+            long accepted = (version < PROTO_V3) ? version : PROTO_V3;
+            if (write(c->fd, &accepted, sizeof(long)) != sizeof(long))
+                return -1;
+            c->state = RD_CODE;
+            break;
+        }
+        case RD_FRAME:
+            if (c->length == -1)
+            { // lunghezza del frame
+                if (avail < sizeof(long))
+                    return 0;
+                memcpy(&c->length, p, sizeof(long));
+                c->pos += sizeof(long);
+                if (c->length <= 0 || c->length > FRAME_MAX)
+                    return -1;
+                break;
             }
+            // decodifico il frame solo quando e' arrivato per intero
+            if (avail < (size_t)c->length)
+                return 0;
+            if (resultsStoreFrame(res, p, c->length) == -1)
+                return -1;
+            c->pos += c->length;
+            c->state = RD_CODE;
+            break;
+        }
+    }
+}
+
+/**
+ * funzione recv_conn
+ * @brief legge dal socket della connessione al piu' size byte, conservando i descrittori eventualmente
+ *        ricevuti con SCM_RIGHTS (MSG_RING)
+ * @return come read
+ */
+static ssize_t recv_conn(conn_t *c, char *buf, size_t size)
+{
+    struct iovec iov = {buf, size};
+    union
+    { // buffer dei dati ausiliari allineato come una cmsghdr
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * RING_FDS)];
+    } ctl;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+
+    ssize_t n = recvmsg(c->fd, &msg, 0);
+    if (n <= 0)
+        return n;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        int nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int *fds = (int *)CMSG_DATA(cmsg);
+        for (int i = 0; i < nfds; i++)
+        {
+            if (c->nfds < RING_FDS)
+                c->fds[c->nfds++] = fds[i];
+            else
+                close(fds[i]); // descrittori in piu' rispetto a quelli di un anello
         }
     }
+    return n;
+}
+
+/**
+ * funzione serve_conn
+ * @brief legge i dati disponibili su una connessione pronta senza bloccarsi e ne consuma i messaggi completi
+ * @return 1 se la connessione e' stata chiusa, 0 altrimenti
+ */
+static int serve_conn(conn_t *c, results_t *res, int *termina)
+{
+    for (int reads = 0; reads < MAX_READS; reads++)
+    {
+        // compatto il buffer e, se il messaggio in corso non ci sta, lo ingrandisco
+        if (c->pos > 0)
+        {
+            memmove(c->buf, c->buf + c->pos, c->len - c->pos);
+            c->len -= c->pos;
+            c->pos = 0;
+        }
+        if (c->len == c->cap)
+        {
+            char *nbuf = realloc(c->buf, c->cap * 2);
+            if (nbuf == NULL)
+            {
+                perror("realloc");
+                close_conn(c, res);
+                return 1;
+            }
+            c->buf = nbuf;
+            c->cap *= 2;
+        }
 
-    return max_fd; // Return the maximum file descriptor value
+        ssize_t n = recv_conn(c, c->buf + c->len, c->cap - c->len);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0; // niente altro da leggere per ora
+            perror("read");
+            close_conn(c, res);
+            return 1;
+        }
+        if (n == 0)
+        { // il client ha chiuso la connessione
+            close_conn(c, res);
+            return 1;
+        }
+        c->len += n;
+        if (parse(c, res, termina) == -1)
+        {
+            fprintf(stderr, "collector: messaggio non valido sulla connessione %d\n", c->fd);
+            close_conn(c, res);
+            return 1;
+        }
+    }
+    return 0;
 }
 
 // main
@@ -64,12 +477,39 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    struct Node *head = NULL; // puntatore alla testa della lista
-    struct Node *temp = NULL; // variabile nodo temporanea
-    long codice = -1;         // 0 --> aggiungi coda, 1 --> stampa, 2 --> termina
+    // con -a i risultati vengono accodati e ordinati solo quando vanno stampati,
+    // con -r <fd> il collector scrive un byte sul descrittore fd appena il socket e' in ascolto,
+    // con -j <file> i risultati vengono accodati al journal file, con -R prima ricaricati dal journal
+    int append_mode = 0;
+    int readyfd = -1;
+    char *journal = NULL;
+    int resume = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "ar:j:R")) != -1)
+    {
+        if (opt == 'a')
+            append_mode = 1;
+        else if (opt == 'r')
+            readyfd = (int)strtol(optarg, NULL, 10);
+        else if (opt == 'j')
+            journal = optarg;
+        else if (opt == 'R')
+            resume = 1;
+    }
+
+    results_t res;
+    if (resultsInit(&res, append_mode) == -1)
+    {
+        perror("resultsInit");
+        return EXIT_FAILURE;
+    }
+    if (journal != NULL && resultsJournal(&res, journal, resume) == -1)
+    {
+        perror(journal);
+        return EXIT_FAILURE;
+    }
     int termina = 0;          // flag di terminazione
     int listenfd;
-    int fdmax;
     int open_connections = 0; // contatore connessioni aperte
     // create a new socket of type SOCK_STREAM in domain AF_UNIX, if protocol we use the default protocol
     if ((listenfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
@@ -98,133 +538,86 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
         ;
     }
+    if (set_nonblock(listenfd) == -1)
+    {
+        perror("fcntl");
+        return EXIT_FAILURE;
+    }
 
-    fd_set set, tmpset;
-    long result = 0;
-    long messagelength = 0;
-    char *message = NULL;
-    int n;
-
-    FD_ZERO(&set);
-    FD_ZERO(&tmpset);
-
-    FD_SET(listenfd, &set); // aggiungo il listener fd al master set
+    // registro il listener in epoll, il suo evento ha data.ptr NULL
+    struct epoll_event ev, events[MAX_EVENTS];
+    if ((epfd = epoll_create1(0)) == -1)
+    {
+        perror("epoll_create1");
+        return EXIT_FAILURE;
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) == -1)
+    {
+        perror("epoll_ctl");
+        return EXIT_FAILURE;
+    }
 
-    fdmax = listenfd;
+    // il socket e' in ascolto: lo segnalo alla farm, che puo' connettersi senza riprovare
+    if (readyfd != -1)
+    {
+        char ok = 1;
+        if (writen(readyfd, &ok, 1) != 1)
+            perror("write");
+        close(readyfd);
+    }
 
     while (!termina || open_connections > 0)
     {
-
-        // copio il set nella variabile temporanea per la select
-        tmpset = set;
-
-        // use select to check if there are any file descriptors ready for reading
-        int ready_fds = select(fdmax + 1, &tmpset, NULL, NULL, NULL);
+        // attendo che almeno un descrittore sia pronto in lettura, al piu' fino alla prossima sincronizzazione del journal
+        int ready_fds = epoll_wait(epfd, events, MAX_EVENTS, resultsSync(&res));
 
         if (ready_fds == -1)
         {
-            perror("select");
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
             exit(EXIT_FAILURE);
         }
 
-        // cerchiamo di capire da quale fd abbiamo ricevuto una richiesta
-        for (int i = 0; i <= fdmax; i++)
+        // ogni evento porta con se' lo stato della connessione da cui abbiamo ricevuto una richiesta
+        for (int i = 0; i < ready_fds; i++)
         {
-            if (FD_ISSET(i, &tmpset))
-            {
-                int connfd;
-                if (i == listenfd)
-                { // e' una nuova richiesta di connessione
-                    if ((connfd = accept(listenfd, (struct sockaddr *)NULL, NULL)) == -1)
-                    {
-                        perror("accept");
-                        return EXIT_FAILURE;
-                    }
-                    FD_SET(connfd, &set);
-                    //printf("Connection opened by client on socket %d\n", connfd);
-                    open_connections++;
-                    if (connfd > fdmax)
-                        fdmax = connfd;
-                }
-                else
-                { /*/* sock I/0 pronto */
-                    // per prima cosa leggo il codice del comando che è un long
-                    if ((n = readn(i, &codice, sizeof(long))) == -1)
-                    {
-                        perror("readn");
-                        break;
-                    }
-
-                    // Check for EOF condition (client closed the connection)
-                    if (n == 0)
-                    {
-                        //printf("Connection closed by client on socket %d\n", i);
-                        //  Remove the socket from the set and update fdmax
-                        FD_CLR(i, &set);
-                        fdmax = aggiorna(&set);
-                        close(i); // Close the socket
-                        open_connections--;
-                        break;
-                    }
-
-                    // printf("codice : %ld\n", codice);
-                    // se il codice indica la terminazione metto termina a 1
-                    if (codice == 2)
-                    {
-                        termina = 1;
-                    }
-                    else if (codice == 1)
-                    { //  codice 1 --> stampo la lista
-                        printList(head);
-                        fflush(stdout);
-                    }
-                    else
-                    { // codice 0 --> inserimento nella lista
-
-                        // per prima cosa leggo il long (risultato/somma)
-                        if ((n = readn(i, &result, sizeof(long))) == -1)
-                        {
-                            perror("readn");
-                            break;
-                        }
-                        // printf("result : %ld\n", result);
-                        //  poi leggo la lunghezza del messaggio contenente il pathname del file
-                        if ((n = readn(i, &messagelength, sizeof(long))) == -1)
-                        {
-                            perror("readn");
-                            break;
-                        }
-                        // printf("message length : %ld\n", messagelength);
-                        //  poi leggo il messaggio della giusta lunghezza
-                        message = malloc(sizeof(char) * (messagelength));
-                        if ((n = readn(i, message, messagelength)) == -1)
-                        {
-
-                            perror("readn");
-                            free(message);
-                            break;
-                        }
-                        // printf("message  : %s\n", message);
-
-                        // creo un nuovo nodo con i campi giusti
-                        temp = newNode(result, message);
-
-                        // devo inserire ordinatamente in lista temp
-                        insertion_sort(&head, temp);
-
-                        // DEBUG
-                        // printList(head);
-
-                        free(message);
-                    }
+            evkind_t *kind = (evkind_t *)events[i].data.ptr;
+            int r;
+            if (kind == NULL)
+            { // nuove richieste di connessione
+                if ((r = add_conns(listenfd)) == -1)
+                    return EXIT_FAILURE;
+                open_connections += r;
+                continue;
+            }
+            if (*kind == EV_RING)
+            { // il worker ha pubblicato risultati nel suo anello
+                conn_t *c = ((ringsrc_t *)kind)->conn;
+                if (c->fd != -1 && ringDrain(&c->ring, store_ring, &res) == -1)
+                {
+                    fprintf(stderr, "collector: anello non valido sulla connessione %d\n", c->fd);
+                    close_conn(c, &res);
+                    open_connections--;
                 }
+                continue;
             }
+            conn_t *c = (conn_t *)kind;
+            if (c->fd == -1)
+                continue; // chiusa da un evento precedente della stessa epoll_wait
+
+            /* sock I/0 pronto: leggo quello che c'e' e consumo tutti i messaggi completi */
+            if (serve_conn(c, &res, &termina))
+                open_connections--;
         }
+        free_closed();
     }
+    close(epfd);
 
-    printList(head);
-    fflush(stdout);
-    free_list(head);
+    resultsPrint(&res);
+    resultsFree(&res);
 
     // printf("collector FINITO\n");
     // fflush(stdout);
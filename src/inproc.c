@@ -0,0 +1,184 @@
+/*********************************/
+//  implementation file inproc.c  /
+/*===============================*/
+
+// include
+#include <util.h>
+#include <inproc.h>
+#include <results.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+/**
+ *  @struct inframe_t
+ *  @brief frame in coda per il collector
+ *
+ *  @var next frame successivo
+ *  @var data contenuto del frame
+ *  @var len  byte di data
+ */
+typedef struct inframe_t
+{
+    struct inframe_t *next;
+    char *data;
+    size_t len;
+} inframe_t;
+
+/**
+ *  @struct inproc_t
+ *  @brief stato del collector interno
+ *
+ *  @var lock   mutua esclusione sulla coda dei frame
+ *  @var events un'unita' per ogni frame consegnato, richiesta di stampa o di terminazione
+ *  @var head   primo frame in coda
+ *  @var tail   ultimo frame in coda
+ *  @var print  richiesta di stampa (SIGUSR1)
+ *  @var stop   richiesta di terminazione
+ *  @var tid    thread collector
+ *  @var res    risultati memorizzati
+ */
+typedef struct inproc_t
+{
+    pthread_mutex_t lock;
+    sem_t events;
+    inframe_t *head;
+    inframe_t *tail;
+    volatile sig_atomic_t print;
+    int stop;
+    pthread_t tid;
+    results_t res;
+} inproc_t;
+
+static inproc_t ic = {PTHREAD_MUTEX_INITIALIZER};
+
+// thread collector: memorizza i frame in arrivo finche' non riceve la richiesta di terminazione
+static void *inproc_thread(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        int timeout = resultsSync(&ic.res);
+        if (timeout == -1)
+        {
+            while (sem_wait(&ic.events) == -1 && errno == EINTR)
+                ;
+        }
+        else
+        { // attendo al piu' fino alla prossima sincronizzazione del journal
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += timeout / 1000;
+            deadline.tv_nsec += (timeout % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (sem_timedwait(&ic.events, &deadline) == -1 && errno == EINTR)
+                ;
+        }
+
+        // prendo tutti i frame in coda con una sola acquisizione della lock
+        pthread_mutex_lock(&ic.lock);
+        inframe_t *f = ic.head;
+        ic.head = ic.tail = NULL;
+        int stop = ic.stop;
+        pthread_mutex_unlock(&ic.lock);
+
+        while (f != NULL)
+        {
+            inframe_t *next = f->next;
+            if (resultsStoreFrame(&ic.res, f->data, f->len) == -1)
+                fprintf(stderr, "collector: frame non valido\n");
+            free(f->data);
+            free(f);
+            f = next;
+        }
+        if (ic.print)
+        {
+            ic.print = 0;
+            resultsPrint(&ic.res);
+        }
+        if (stop)
+            break; // i frame consegnati prima della richiesta di terminazione sono stati tutti memorizzati
+    }
+    resultsPrint(&ic.res);
+    resultsFree(&ic.res);
+    return NULL;
+}
+
+int inprocStart(int append_mode, const char *journal, int resume)
+{
+    if (resultsInit(&ic.res, append_mode) == -1)
+        return -1;
+    if (journal != NULL && resultsJournal(&ic.res, journal, resume) == -1)
+    {
+        int errtemp = errno;
+        resultsFree(&ic.res);
+        errno = errtemp;
+        return -1;
+    }
+    if (sem_init(&ic.events, 0, 0) == -1)
+    {
+        resultsFree(&ic.res);
+        return -1;
+    }
+    ic.head = ic.tail = NULL;
+    ic.print = 0;
+    ic.stop = 0;
+    int r;
+    if ((r = pthread_create(&ic.tid, NULL, inproc_thread, NULL)) != 0)
+    {
+        sem_destroy(&ic.events);
+        resultsFree(&ic.res);
+        errno = r;
+        return -1;
+    }
+    return 0;
+}
+
+int inprocPush(char *frame, size_t len)
+{
+    inframe_t *f = malloc(sizeof(inframe_t));
+    if (f == NULL)
+    {
+        free(frame);
+        return -1;
+    }
+    f->next = NULL;
+    f->data = frame;
+    f->len = len;
+
+    pthread_mutex_lock(&ic.lock);
+    if (ic.tail == NULL)
+        ic.head = f;
+    else
+        ic.tail->next = f;
+    ic.tail = f;
+    pthread_mutex_unlock(&ic.lock);
+    sem_post(&ic.events);
+    return 0;
+}
+
+void inprocPrint(void)
+{
+    ic.print = 1;
+    sem_post(&ic.events);
+}
+
+int inprocStop(void)
+{
+    pthread_mutex_lock(&ic.lock);
+    ic.stop = 1;
+    pthread_mutex_unlock(&ic.lock);
+    sem_post(&ic.events);
+
+    int r;
+    if ((r = pthread_join(ic.tid, NULL)) != 0)
+    {
+        errno = r;
+        return -1;
+    }
+    sem_destroy(&ic.events);
+    return 0;
+}
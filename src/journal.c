@@ -0,0 +1,191 @@
+/**********************************/
+//  implementation file journal.c  /
+/*================================*/
+
+// include
+#include <util.h>
+#include <journal.h>
+#include <fcntl.h>
+
+// dimensione iniziale del buffer dei record
+#define JOURNAL_BUF (64 * 1024)
+
+long journalLoad(const char *path, int (*fun)(long, const char *, void *), void *arg)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+        return (errno == ENOENT) ? 0 : -1; // nessun journal: nessun risultato da ricaricare
+
+    long valid = 0;
+    long head[2];
+    char name[PATH_MAX];
+    while (fread(head, sizeof(long), 2, in) == 2)
+    {
+        // un record troncato o non valido chiude il journal: i record successivi non sono affidabili
+        if (head[1] <= 0 || head[1] > PATH_MAX || fread(name, 1, head[1], in) != (size_t)head[1] || name[head[1] - 1] != '\0')
+            break;
+        if (fun != NULL && fun(head[0], name, arg) == -1)
+        {
+            fclose(in);
+            return -1;
+        }
+        valid += 2 * sizeof(long) + head[1];
+    }
+    fclose(in);
+    return valid;
+}
+
+int journalOpen(journal_t *j, const char *path, int resume)
+{
+    j->buf = NULL;
+    j->len = j->cap = j->unsynced = 0;
+    long valid = 0;
+    if (resume && (valid = journalLoad(path, NULL, NULL)) == -1)
+        return -1;
+    if ((j->fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (resume ? 0 : O_TRUNC), 0644)) == -1)
+        return -1;
+    // il record incompleto lasciato da un'interruzione viene sovrascritto dai nuovi record
+    if (resume && (ftruncate(j->fd, valid) == -1 || lseek(j->fd, 0, SEEK_END) == -1))
+    {
+        int errtemp = errno;
+        close(j->fd);
+        errno = errtemp;
+        return -1;
+    }
+    return 0;
+}
+
+int journalAppend(journal_t *j, long result, const char *name)
+{
+    long length = strlen(name) + 1;
+    size_t size = 2 * sizeof(long) + length;
+    if (j->len + size > j->cap)
+    {
+        size_t cap = j->cap ? j->cap : JOURNAL_BUF;
+        while (cap < j->len + size)
+            cap *= 2;
+        char *buf = realloc(j->buf, cap);
+        if (buf == NULL)
+            return -1;
+        j->buf = buf;
+        j->cap = cap;
+    }
+    memcpy(j->buf + j->len, &result, sizeof(long));
+    memcpy(j->buf + j->len + sizeof(long), &length, sizeof(long));
+    memcpy(j->buf + j->len + 2 * sizeof(long), name, length);
+    j->len += size;
+    return 0;
+}
+
+int journalSync(journal_t *j, int force)
+{
+    if (j->len > 0)
+    {
+        if (j->unsynced == 0)
+            clock_gettime(CLOCK_MONOTONIC, &j->oldest);
+        for (size_t off = 0; off < j->len;)
+        {
+            ssize_t r = write(j->fd, j->buf + off, j->len - off);
+            if (r == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                perror("journal");
+                break; // i record non scritti vengono persi, il collector prosegue
+            }
+            off += r;
+        }
+        j->unsynced += j->len;
+        j->len = 0;
+    }
+    if (j->unsynced == 0)
+        return -1;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed = (now.tv_sec - j->oldest.tv_sec) * 1000 + (now.tv_nsec - j->oldest.tv_nsec) / 1000000;
+    if (force || j->unsynced >= JOURNAL_SYNC_BYTES || elapsed >= JOURNAL_SYNC_MS)
+    {
+        if (fdatasync(j->fd) == -1)
+            perror("fdatasync");
+        j->unsynced = 0;
+        return -1;
+    }
+    return (int)(JOURNAL_SYNC_MS - elapsed);
+}
+
+void journalClose(journal_t *j)
+{
+    journalSync(j, 1);
+    close(j->fd);
+    free(j->buf);
+    j->buf = NULL;
+}
+
+// insieme dei pathname del journal: tabella hash ad indirizzamento aperto, piena al piu' per meta'
+static char **skip_set = NULL;
+static size_t skip_cap = 0;
+static size_t skip_n = 0;
+
+static size_t skip_hash(const char *s)
+{
+    size_t h = 0xCBF29CE484222325UL;
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 0x100000001B3UL;
+    return h;
+}
+
+// posizione di name nell'insieme oppure primo elemento libero della sua scansione
+static char **skip_find(char **set, size_t cap, const char *name)
+{
+    size_t i = skip_hash(name) & (cap - 1);
+    while (set[i] != NULL && strcmp(set[i], name) != 0)
+        i = (i + 1) & (cap - 1);
+    return &set[i];
+}
+
+static int skip_add(long result, const char *name, void *arg)
+{
+    (void)result;
+    (void)arg;
+    if (2 * (skip_n + 1) > skip_cap)
+    { // raddoppio la tabella
+        size_t cap = skip_cap ? skip_cap * 2 : 1024;
+        char **set = calloc(cap, sizeof(char *));
+        if (set == NULL)
+            return -1;
+        for (size_t i = 0; i < skip_cap; i++)
+            if (skip_set[i] != NULL)
+                *skip_find(set, cap, skip_set[i]) = skip_set[i];
+        free(skip_set);
+        skip_set = set;
+        skip_cap = cap;
+    }
+    char **slot = skip_find(skip_set, skip_cap, name);
+    if (*slot == NULL)
+    {
+        if ((*slot = strdup(name)) == NULL)
+            return -1;
+        skip_n++;
+    }
+    return 0;
+}
+
+int journalSkipLoad(const char *path)
+{
+    return journalLoad(path, skip_add, NULL) == -1 ? -1 : 0;
+}
+
+int journalSkip(const char *name)
+{
+    return skip_n > 0 && *skip_find(skip_set, skip_cap, name) != NULL;
+}
+
+void journalSkipFree(void)
+{
+    for (size_t i = 0; i < skip_cap; i++)
+        free(skip_set[i]);
+    free(skip_set);
+    skip_set = NULL;
+    skip_cap = skip_n = 0;
+}
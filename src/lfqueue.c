@@ -0,0 +1,93 @@
+/***********************************/
+//  implementation file lfqueue.c   /
+/*=================================*/
+
+// include
+#include <util.h>
+#include <lfqueue.h>
+
+lfqueue_t *lfqCreate(size_t cap)
+{
+    if (cap == 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    // con un solo slot il numero di sequenza "pieno" della posizione pos (pos + 1) coinciderebbe con
+    // quello "libero" della posizione pos + 1 e un produttore sovrascriverebbe un task non ancora estratto
+    if (cap < LFQ_MIN_CAP)
+        cap = LFQ_MIN_CAP;
+    lfqueue_t *q = malloc(sizeof(lfqueue_t));
+    if (q == NULL)
+        return NULL;
+    if ((q->slots = malloc(sizeof(lfslot_t) * cap)) == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    // lo slot i e' libero per il produttore della posizione i
+    for (size_t i = 0; i < cap; i++)
+        q->slots[i].seq = i;
+    q->cap = cap;
+    q->tail = q->head = 0;
+    return q;
+}
+
+int lfqPush(lfqueue_t *q, const taskfun_t *task)
+{
+    size_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        lfslot_t *slot = &q->slots[pos % q->cap];
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+        if (diff == 0)
+        { // slot libero, provo a prenotare la posizione
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                slot->task = *task;
+                // pubblico il task ai consumatori
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+            // un altro produttore ha preso la posizione, pos e' stato aggiornato dalla CAS
+        }
+        else if (diff < 0)
+            return -1; // lo slot contiene ancora il task di un giro precedente: coda piena
+        else
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    }
+}
+
+int lfqPop(lfqueue_t *q, taskfun_t *task)
+{
+    size_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        lfslot_t *slot = &q->slots[pos % q->cap];
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - (pos + 1));
+        if (diff == 0)
+        { // slot pieno, provo a prenotare la posizione
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                *task = slot->task;
+                // restituisco lo slot ai produttori del giro successivo
+                __atomic_store_n(&slot->seq, pos + q->cap, __ATOMIC_RELEASE);
+                return 0;
+            }
+        }
+        else if (diff < 0)
+            return -1; // nessun task pubblicato in questa posizione: coda vuota
+        else
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    }
+}
+
+void lfqDestroy(lfqueue_t *q)
+{
+    if (q == NULL)
+        return;
+    free(q->slots);
+    free(q);
+}
@@ -55,12 +55,25 @@ reference : https://www.gnu.org/software/libc/manual/html_node/Feature-Test-Macr
 #include <threadpool.h>
 #include <getopt.h>
 #include <worker.h>
+#include <wsum.h>
+#include <scheduler.h>
+#include <pathalloc.h>
+#include <walker.h>
+#include <inproc.h>
+#include <rcache.h>
+#include <watch.h>
+#include <server.h>
+#include <journal.h>
+#include <pacer.h>
 
 // define
 // alcuni valori di default
 #define NTHREAD 4 // numero dei thread worker di default
 #define QLEN 8    // lunghezza di default della coda concorrente dei task pendenti
 #define DELAY 0   // distanza di sottomissione dei task dal master ai worker espressa in ms
+#define CHUNK 0   // dimensione in byte dei chunk in cui suddividere i file grandi, 0 per non suddividerli
+#define WINDOW 0  // finestra di lookahead della politica lpt, 0 per considerare tutti i file prima di sottometterli
+#define NWALKER 4 // numero di default dei thread che esplorano la directory passata con -d
 
 /*******************************************/
 // Alcune variabili globali
@@ -75,12 +88,40 @@ static volatile sig_atomic_t termina = 0;
 // file descriptor del socket di comunicazione tra sig_handler e collector
 static int serverfd;
 
+// --inproc-collector: i risultati vengono raccolti da un thread della farm invece che dal processo collector
+static int inproc = 0;
+
 // codice per il messaggio di stampa nel protocollo prestabilito di comunicazione tra master e collector
 static long codice_stampa = 1;
 
 // dichiarazione funzione compute
 int compute(char *file_name, long *result);
 
+// dimensione in byte dei chunk in cui vengono suddivisi i file piu' grandi (0 nessuna suddivisione)
+static long chunk_size = CHUNK;
+
+// scheduler della politica lpt (largest file first), NULL con la politica fifo (ordine di scoperta)
+static scheduler_t *lpt = NULL;
+
+// limite alla velocita' di sottomissione (-t, --rate-files, --rate-bytes), NULL nessun limite
+static pacer_t *pacer = NULL;
+
+// lotto dei file da sottomettere con la politica fifo senza ritardo: viene inviato al threadpool con una sola
+// addManyTasksToThreadPool quando e' pieno e alla fine di ogni directory esplorata. Ogni thread di esplorazione
+// ha il proprio lotto
+#define BATCH 64
+static __thread void *batch[BATCH];
+static __thread int batch_n = 0;
+// lotto dei file il cui risultato e' nella cache (-C): i task inviano il risultato senza leggere il file
+static __thread void *hits[BATCH];
+static __thread int hits_n = 0;
+// lotto dei file letti da un elenco (--files-from) di cui la stat viene rimandata al worker
+static __thread void *listed[BATCH];
+static __thread int listed_n = 0;
+
+// mutua esclusione tra i thread di esplorazione sullo scheduler lpt
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*******************************************/
 // signal handler
 /*=========================================*/
@@ -107,7 +148,10 @@ static void sighandler(int signum)
   case SIGUSR1:
     // printf("Received SIGUSR1 signal.\n");
     // signal safety --> https://man7.org/linux/man-pages/man7/signal-safety.7.html --> write is asynchronous signal safe
-    writen(serverfd, &codice_stampa, sizeof(long));
+    if (inproc)
+      inprocPrint(); // sem_post e' async-signal-safe
+    else
+      writen(serverfd, &codice_stampa, sizeof(long));
     break;
   default:;
     // printf("Received signal number: %d\n", signum);
@@ -121,7 +165,10 @@ static void sighandler(int signum)
 // funzione che stampa il messaggio d'uso
 int arg_h(const char *programname)
 {
-  printf("usage: %s -n <num_worker> -q <qlen> -t <delay> [-d <nomedir>] nomefile [nomefile...] -h\n", programname);
+  printf("usage: %s -n <num_worker> -q <qlen> -t <delay> [-c <chunk_bytes>] [-S fifo|lpt] [-w <window>] [-Q mutex|lockfree|steal] [-W <num_walker>] [-P 1|2|3] [-a] [--inproc-collector] [--rate-files <files/s>] [--rate-bytes <bytes/s>] [-C <cachefile> [-i|--append-only]] [-d <nomedir> [--watch]] [--files-from <file|-> [--null]] [--journal <file> [--resume]] [--server <socket>] nomefile [nomefile...] -h\n       %s --submit <socket> [-d <nomedir>] [nomefile...]\n"
+         "  -i, --append-only: i file cresciuti dall'ultima esecuzione vengono calcolati solo nella parte aggiunta,\n"
+         "                     assumendo che siano stati solo estesi in coda: una riscrittura nel mezzo del contenuto\n"
+         "                     gia' calcolato non viene rilevata e il risultato e' errato\n", programname, programname);
   return -1;
 }
 
@@ -138,6 +185,19 @@ int arg_n(const char *n, long *nthread)
   return 0;
 }
 
+// funzione arg_W
+int arg_W(const char *W, long *nwalker)
+{
+  long tmp;
+  if (isNumber(W, &tmp) != 0 || tmp < 1)
+  {
+    printf("l'argomento di '-W' non e' valido\n");
+    return -1;
+  }
+  *nwalker = tmp;
+  return 0;
+}
+
 // funzione arg_q
 int arg_q(const char *m, long *qlen)
 {
@@ -164,6 +224,91 @@ int arg_t(const char *t, long *delay)
   return 0;
 }
 
+// funzione arg_rate: limite di velocita' di --rate-files e --rate-bytes
+int arg_rate(const char *name, const char *r, long *rate)
+{
+  long tmp;
+  if (isNumber(r, &tmp) != 0 || tmp < 0)
+  {
+    printf("l'argomento di '--%s' non e' valido\n", name);
+    return -1;
+  }
+  *rate = tmp;
+  return 0;
+}
+
+// funzione arg_c
+int arg_c(const char *c, long *chunk)
+{
+  long tmp;
+  if (isNumber(c, &tmp) != 0 || tmp < 0)
+  {
+    printf("l'argomento di '-c' non e' valido\n");
+    return -1;
+  }
+  // i chunk devono contenere un numero intero di long
+  *chunk = (tmp + sizeof(long) - 1) / sizeof(long) * sizeof(long);
+  return 0;
+}
+
+// funzione arg_S
+int arg_S(const char *S, int *use_lpt)
+{
+  if (strcmp(S, "fifo") == 0)
+    *use_lpt = 0;
+  else if (strcmp(S, "lpt") == 0)
+    *use_lpt = 1;
+  else
+  {
+    printf("l'argomento di '-S' non e' valido (fifo o lpt)\n");
+    return -1;
+  }
+  return 0;
+}
+
+// funzione arg_Q
+int arg_Q(const char *Q, int *queue_type)
+{
+  if (strcmp(Q, "mutex") == 0)
+    *queue_type = POOL_QUEUE_MUTEX;
+  else if (strcmp(Q, "lockfree") == 0)
+    *queue_type = POOL_QUEUE_LOCKFREE;
+  else if (strcmp(Q, "steal") == 0)
+    *queue_type = POOL_QUEUE_STEALING;
+  else
+  {
+    printf("l'argomento di '-Q' non e' valido (mutex, lockfree o steal)\n");
+    return -1;
+  }
+  return 0;
+}
+
+// funzione arg_P
+int arg_P(const char *P, int *protocol)
+{
+  long tmp;
+  if (isNumber(P, &tmp) != 0 || tmp < PROTO_V1 || tmp > PROTO_V3)
+  {
+    printf("l'argomento di '-P' non e' valido (1, 2 o 3)\n");
+    return -1;
+  }
+  *protocol = (int)tmp;
+  return 0;
+}
+
+// funzione arg_w
+int arg_w(const char *w, long *window)
+{
+  long tmp;
+  if (isNumber(w, &tmp) != 0 || tmp < 0)
+  {
+    printf("l'argomento di '-w' non e' valido\n");
+    return -1;
+  }
+  *window = tmp;
+  return 0;
+}
+
 // funzione arg_d
 int arg_d(char *d, char **dir_name)
 {
@@ -171,82 +316,318 @@ int arg_d(char *d, char **dir_name)
   return 0;
 }
 
-/** funzione find
- * @brief: esplora il file system a partire dalla directory passata come parametro in cerca di file regolari
- *       da sottomettere al threadpool
- * @param nomedir directory di partenza
+/** funzione submit
+ * @brief: sottomette al threadpool un file regolare, se il file e' piu' grande di chunk_size viene
+ *         suddiviso in chunk calcolati in parallelo i cui risultati parziali vengono combinati
+ *         in un unico risultato prima dell'invio al collector
+ * @param tp threadpool a cui sottomettere i task
+ * @param file_name pathname del file
+ * @param statbuf risultato della stat del file, puo' essere NULL se chunk_size e' 0
+ * @return :
+ *   0 successo
+ *   !=0 il file non e' stato sottomesso
+ */
+int submit(threadpool_t *tp, const char *file_name, const struct stat *statbuf)
+{
+  long chunk_elem = chunk_size / sizeof(long);
+  if (chunk_elem == 0) // senza suddivisione in chunk statbuf non viene usato e puo' essere NULL
+    return addToThreadPool(tp, (int (*)(void *, void *))compute, (void *)file_name);
+
+  long nelem = statbuf->st_size / sizeof(long);
+  if (nelem <= chunk_elem)
+    return addToThreadPool(tp, (int (*)(void *, void *))compute, (void *)file_name);
+
+  // con un checkpoint nella cache (modalita' incrementale) compute legge solo la coda del file
+  rckey_t key;
+  long psize, presult;
+  unsigned long pcheck;
+  rcacheKey(statbuf, &key);
+  if (rcachePrefix(&key, &psize, &presult, &pcheck))
+    return addToThreadPool(tp, (int (*)(void *, void *))compute, (void *)file_name);
+
+  long nchunks = (nelem + chunk_elem - 1) / chunk_elem;
+  chunkjob_t *job = newChunkJob(file_name, statbuf, nchunks);
+  if (job == NULL)
+  {
+    perror("newChunkJob");
+    return -1;
+  }
+  for (long i = 0; i < nchunks; i++)
+  {
+    chunk_t *chunk = pathAlloc(sizeof(chunk_t));
+    if (chunk == NULL)
+    {
+      perror("pathAlloc");
+      cancelChunks(job, nchunks - i);
+      return -1;
+    }
+    chunk->job = job;
+    chunk->first = i * chunk_elem;
+    chunk->count = (i == nchunks - 1) ? nelem - chunk->first : chunk_elem;
+    int r = 0;
+    if (termina || (r = addTaskToThreadPool(tp, (int (*)(void *, void *))compute_chunk, chunk)) != 0)
+    { // i chunk rimanenti non verranno eseguiti, il file viene scartato
+      pathFree(chunk);
+      cancelChunks(job, nchunks - i);
+      return termina ? 1 : r;
+    }
+  }
+  return 0;
+}
+
+// sottomette al threadpool gli n task di un lotto che eseguono fun, gli argomenti non accettati vengono liberati
+static int flush_tasks(threadpool_t *tp, int (*fun)(void *, void *), void *args[], int *n)
+{
+  int r = 0;
+  if (*n > 0 && !termina)
+    r = addManyTasksToThreadPool(tp, fun, args, *n);
+  if (r == -1)
+    perror("addManyTasksToThreadPool");
+  for (int i = (r > 0 ? r : 0); i < *n; i++)
+    pathFree(args[i]);
+  *n = 0;
+  return (r == -1) ? -1 : 0;
+}
+
+/** funzione flush_batch
+ * @brief: sottomette al threadpool i file accumulati nel lotto e quelli trovati nella cache, i file non accettati vengono scartati
  * @param tp threadpool a cui sottomettere i task
- * @param delay ritardo in ms tra una sottomissione e l'altra
  * @return :
- *   1 successo
+ *   0 successo
  *   -1 errore
  */
-int find(const char nomedir[], threadpool_t *tp, long delay)
+static int flush_batch(threadpool_t *tp)
 {
-  DIR *dir;
+  int r = flush_tasks(tp, (int (*)(void *, void *))compute, batch, &batch_n);
+  if (flush_tasks(tp, (int (*)(void *, void *))cached_result, hits, &hits_n) == -1)
+    r = -1;
+  if (flush_tasks(tp, (int (*)(void *, void *))compute_listed, listed, &listed_n) == -1)
+    r = -1;
+  return r;
+}
 
-  if ((dir = opendir(nomedir)) == NULL)
+/** funzione hit_add
+ * @brief: aggiunge al lotto dei risultati in cache il file file_name con risultato result, se il lotto e' pieno lo sottomette
+ * @return :
+ *   0 successo
+ *   -1 errore
+ */
+static int hit_add(threadpool_t *tp, const char *file_name, long result)
+{
+  char *arg = newCachedTask(file_name, result);
+  if (arg == NULL)
   {
-    print_error("Errore aprendo la directory %s\n", nomedir);
+    perror("newCachedTask");
     return -1;
   }
-  else
+  hits[hits_n++] = arg;
+  return (hits_n == BATCH) ? flush_batch(tp) : 0;
+}
+
+/** funzione batch_add
+ * @brief: aggiunge un file al lotto, se il lotto e' pieno lo sottomette al threadpool
+ * @param tp threadpool a cui sottomettere i task
+ * @param file_name pathname del file
+ * @return :
+ *   0 successo
+ *   -1 errore
+ */
+static int batch_add(threadpool_t *tp, const char *file_name)
+{
+  char *str_temp = pathDup(file_name);
+  if (str_temp == NULL)
   {
-    // sono dentro la directory
-    struct dirent *file;
+    perror("pathDup");
+    return -1;
+  }
+  batch[batch_n++] = str_temp;
+  return (batch_n == BATCH) ? flush_batch(tp) : 0;
+}
 
-    while ((errno = 0, file = readdir(dir)) != NULL)
-    { // finchè ci sono entry nella directory
-      struct stat statbuf;
-      char *new_dir = (char *)malloc(sizeof(char) * (NAME_MAX));
-      new_dir[0] = '\0';
-      strcat(new_dir, nomedir);
-      if (new_dir[strlen(new_dir) - 1] != '/')
-      {
-        strcat(new_dir, "/");
-      }
-      strcat(new_dir, file->d_name);
-      if (!termina)
+/** funzione submit_next
+ * @brief: estrae dallo scheduler lpt il file piu' grande e lo sottomette al threadpool, rispettando l'eventuale
+ *         limite di velocita'. Il file viene estratto con sched_lock, l'attesa e la sottomissione avvengono senza:
+ *         gli altri thread di esplorazione continuano a inserire file nello scheduler
+ * @param tp threadpool a cui sottomettere i task
+ * @return :
+ *   0 successo
+ *   !=0 nessun file sottomesso
+ */
+static int submit_next(threadpool_t *tp)
+{
+  sched_item_t item;
+  pthread_mutex_lock(&sched_lock);
+  int empty = (schedPop(lpt, &item) == -1);
+  pthread_mutex_unlock(&sched_lock);
+  if (empty)
+    return 1;
+  if (pacer != NULL)
+    pacerWait(pacer, item.st.st_size, &termina);
+  int r = termina ? 1 : submit(tp, item.file_name, &item.st);
+  free(item.file_name);
+  return r;
+}
+
+/** funzione schedule
+ * @brief: passa un file regolare alla politica di schedulazione: con fifo il file viene sottomesso subito,
+ *         con lpt viene trattenuto nello scheduler e quando la finestra di lookahead e' piena viene
+ *         sottomesso il file piu' grande tra quelli trattenuti
+ * @param tp threadpool a cui sottomettere i task
+ * @param file_name pathname del file
+ * @param statbuf risultato della stat del file, puo' essere NULL se non servono le dimensioni (politica fifo senza chunk,
+ *        cache e limite di velocita')
+ * @return :
+ *   0 successo
+ *   -1 errore
+ */
+int schedule(threadpool_t *tp, const char *file_name, const struct stat *statbuf)
+{
+  if (journalSkip(file_name))
+    return 0; // --resume: il risultato e' gia' nel journal ed e' stato ricaricato dal collector
+  if (rcacheEnabled())
+  { // il file non e' cambiato dall'ultima esecuzione: il risultato va al collector senza ritardo ne' calcolo
+    rckey_t key;
+    long result;
+    rcacheKey(statbuf, &key);
+    if (rcacheLookup(&key, &result))
+      return hit_add(tp, file_name, result);
+  }
+  if (lpt == NULL)
+  {
+    long chunk_elem = chunk_size / sizeof(long);
+    if (pacer == NULL && (chunk_elem == 0 || statbuf->st_size / (long)sizeof(long) <= chunk_elem))
+      return batch_add(tp, file_name); // nessun limite ne' suddivisione in chunk: il file entra nel lotto
+    // attesa del limite e sottomissione senza lock: un thread fermo sulla coda piena del pool non ferma gli altri
+    // thread di esplorazione. I chunk di file diversi possono alternarsi nella coda, ogni chunk e' indipendente
+    if (pacer != NULL && pacerWait(pacer, statbuf->st_size, &termina))
+      return 0;
+    if (!termina)
+      submit(tp, file_name, statbuf);
+    return 0;
+  }
+
+  pthread_mutex_lock(&sched_lock);
+  if (schedPush(lpt, file_name, statbuf) == -1)
+  {
+    perror("schedPush");
+    pthread_mutex_unlock(&sched_lock);
+    return -1;
+  }
+  int full = schedFull(lpt);
+  pthread_mutex_unlock(&sched_lock);
+  while (!termina && full)
+  {
+    submit_next(tp);
+    pthread_mutex_lock(&sched_lock);
+    full = schedFull(lpt);
+    pthread_mutex_unlock(&sched_lock);
+  }
+  return 0;
+}
+
+/** funzione read_list
+ * @brief: sottomette al threadpool i file elencati in name ("-" per lo standard input), uno per riga oppure
+ *         separati da '\0' se nul_sep e' diverso da 0. L'elenco viene letto in streaming: i file entrano nel pool
+ *         man mano che vengono letti. Se la politica di schedulazione non ha bisogno della stat (fifo senza
+ *         limite di velocita', chunk e cache) la stat viene fatta dal worker (compute_listed), altrimenti qui come per argv
+ * @param tp threadpool a cui sottomettere i task
+ * @return :
+ *   0 successo
+ *   -1 errore
+ */
+static int read_list(threadpool_t *tp, const char *name, int nul_sep)
+{
+  FILE *in = (strcmp(name, "-") == 0) ? stdin : fopen(name, "r");
+  if (in == NULL)
+    return -1;
+  int need_stat = (lpt != NULL || chunk_size > 0 || pacer != NULL || rcacheEnabled());
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  while (!termina && (len = getdelim(&line, &cap, nul_sep ? '\0' : '\n', in)) > 0)
+  {
+    if (line[len - 1] == (nul_sep ? '\0' : '\n'))
+      line[--len] = '\0';
+    if (len == 0)
+      continue;
+    if (!need_stat)
+    {
+      if (journalSkip(line))
+        continue;
+      char *arg = pathDup(line);
+      if (arg == NULL)
       {
-        if (stat(new_dir, &statbuf) == -1)
-        { // faccio la stat
-          perror("stat");
-          print_error("Errore facendo stat di %s\n", file->d_name);
-          return -1;
-        }
-        if (S_ISDIR(statbuf.st_mode))
-        { // se è una directory
-          if (!isdot(file->d_name))
-          { // se non è la directory corrente o padre
-            find(new_dir, tp, delay);
-            // chiamo la find sul sottoalbero
-          }
-        }
-        else
-        { // se non è una directory
-          if (S_ISREG(statbuf.st_mode))
-          { // se il file è un file regolare
-            msleep(delay);
-            // printf("dormito per %ld ms\n", delay);
-
-            if (!termina)
-            {
-              addToThreadPool(tp, (int (*)(void *, void *))compute, new_dir);
-              // printf("Sottomesso al threadpool file : %s\n", new_dir);
-            }
-          }
-        }
+        perror("pathDup");
+        break;
       }
-      free(new_dir);
-    }
-    if (errno != 0)
-    {
-      perror("readdir");
-      closedir(dir);
-      return -1;
+      listed[listed_n++] = arg;
+      if (listed_n == BATCH)
+        flush_batch(tp);
+      continue;
     }
-    closedir(dir);
+    struct stat statbuf;
+    if (stat(line, &statbuf) == -1)
+      perror(line);
+    else if (S_ISREG(statbuf.st_mode))
+      schedule(tp, line, &statbuf);
+  }
+  flush_batch(tp);
+  free(line);
+  if (in != stdin)
+    fclose(in);
+  return 0;
+}
+
+// threadpool usato dalle callback dell'esplorazione della directory passata con -d
+typedef struct walkctx_t
+{
+  threadpool_t *tp;
+} walkctx_t;
+
+// callback dell'esplorazione: passa il file regolare alla politica di schedulazione
+static int walk_file(const char *path, const struct stat *statbuf, void *arg)
+{
+  walkctx_t *ctx = (walkctx_t *)arg;
+  if (termina)
     return 1;
+  return schedule(ctx->tp, path, statbuf);
+}
+
+// callback dell'esplorazione: sottometto i file della directory ancora nel lotto
+static void walk_dir_done(void *arg)
+{
+  flush_batch(((walkctx_t *)arg)->tp);
+}
+
+// callback dell'osservazione (--watch): sottometto i file nel lotto e quelli trattenuti dallo scheduler lpt
+static void watch_done(void *arg)
+{
+  walkctx_t *ctx = (walkctx_t *)arg;
+  flush_batch(ctx->tp);
+  if (lpt != NULL)
+  {
+    while (!termina && submit_next(ctx->tp) == 0)
+      ;
+  }
+}
+
+/**
+ * funzione abort_run
+ * @brief errore dopo l'avvio del collector: distrugge il threadpool (tp puo' essere NULL) e chiede al collector di
+ *        terminare, attendendolo, prima che il master esca
+ */
+static void abort_run(threadpool_t *tp, pid_t pid)
+{
+  if (tp != NULL)
+    destroyThreadPool(tp, 0); // nessun task e' ancora stato sottomesso
+  if (inproc)
+    inprocStop();
+  else
+  {
+    long codice = 2;
+    writen(serverfd, &codice, sizeof(long));
+    close(serverfd);
+    waitpid(pid, NULL, 0);
   }
 }
 
@@ -271,11 +652,199 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
-  pid_t pid = fork();
+  // le opzioni vengono lette prima della fork perche' alcune vanno passate al collector
+  // setto i valori di default
+  long nthread = NTHREAD, qlen = QLEN, delay = DELAY, window = WINDOW, nwalker = NWALKER;
+  int use_lpt = 0;
+  int queue_type = POOL_QUEUE_MUTEX;
+  int protocol = PROTO_V2; // versione del protocollo tra worker e collector
+  int append_mode = 0; // -a: il collector ordina i risultati solo quando li stampa
+
+  char *dir_name = NULL;
+  char *cache_name = NULL; // -C: file della cache persistente dei risultati
+  int incremental = 0;     // -i: i risultati in cache fanno da checkpoint per i file estesi in coda (assume file solo estesi)
+  int watch_mode = 0;      // --watch: dopo l'esplorazione la farm resta in attesa dei nuovi file della directory
+  char *server_name = NULL; // --server: socket di controllo su cui la farm accetta job finche' non termina
+  char *submit_name = NULL; // --submit: la farm invia un job al server in ascolto sul socket e ne stampa i risultati
+  char *list_name = NULL;   // --files-from: elenco dei file da elaborare ("-" per lo standard input)
+  int nul_sep = 0;          // --null: i pathname dell'elenco sono separati da '\0' invece che da '\n'
+  long files_rate = 0;      // --rate-files: file sottomessi al secondo, 0 nessun limite
+  long bytes_rate = 0;      // --rate-bytes: byte sottomessi al secondo, 0 nessun limite
+  char *journal_name = NULL; // --journal: il collector accoda ogni risultato ricevuto al journal
+  int resume = 0;            // --resume: i file gia' presenti nel journal non vengono ricalcolati
+
+  int opt;
+  // opzioni lunghe, con la stessa gestione delle opzioni brevi
+  static struct option long_options[] = {
+      {"inproc-collector", no_argument, NULL, 'I'},
+      {"cache", required_argument, NULL, 'C'},
+      {"incremental", no_argument, NULL, 'i'},
+      {"append-only", no_argument, NULL, 'i'},
+      {"watch", no_argument, NULL, 'O'},
+      {"server", required_argument, NULL, 'L'},
+      {"submit", required_argument, NULL, 'J'},
+      {"files-from", required_argument, NULL, 'F'},
+      {"null", no_argument, NULL, 'N'},
+      {"journal", required_argument, NULL, 'j'},
+      {"resume", no_argument, NULL, 'R'},
+      {"rate-files", required_argument, NULL, 'f'},
+      {"rate-bytes", required_argument, NULL, 'b'},
+      {0, 0, 0, 0}};
+
+  while ((opt = getopt_long(argc, argv, ":n:q:t:c:S:w:Q:W:P:C:d:h:ai", long_options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      arg_n(optarg, &nthread);
+      break;
+    case 'q':
+      arg_q(optarg, &qlen);
+      break;
+    case 't':
+      arg_t(optarg, &delay);
+      break;
+    case 'c':
+      arg_c(optarg, &chunk_size);
+      break;
+    case 'S':
+      arg_S(optarg, &use_lpt);
+      break;
+    case 'w':
+      arg_w(optarg, &window);
+      break;
+    case 'Q':
+      arg_Q(optarg, &queue_type);
+      break;
+    case 'W':
+      arg_W(optarg, &nwalker);
+      break;
+    case 'P':
+      arg_P(optarg, &protocol);
+      break;
+    case 'd':
+      arg_d(optarg, &dir_name);
+      break;
+    case 'h':
+      arg_h(argv[0]);
+      break;
+    case 'a':
+      append_mode = 1;
+      break;
+    case 'I':
+      inproc = 1;
+      break;
+    case 'C':
+      cache_name = optarg;
+      break;
+    case 'i':
+      incremental = 1;
+      break;
+    case 'O':
+      watch_mode = 1;
+      break;
+    case 'L':
+      server_name = optarg;
+      break;
+    case 'J':
+      submit_name = optarg;
+      break;
+    case 'F':
+      list_name = optarg;
+      break;
+    case 'N':
+      nul_sep = 1;
+      break;
+    case 'j':
+      journal_name = optarg;
+      break;
+    case 'R':
+      resume = 1;
+      break;
+    case 'f':
+      arg_rate("rate-files", optarg, &files_rate);
+      break;
+    case 'b':
+      arg_rate("rate-bytes", optarg, &bytes_rate);
+      break;
+    case ':':
+    { // restituito se manca il valore corrispondente ad un' opzione
+      // printf("l'opzione '-%c' richiede un argomento\n", optopt);
+    }
+    break;
+    case '?':
+    { // restituito se getopt trova una opzione non riconosciuta
+      //  printf("l'opzione '-%c' non e' gestita\n", optopt);
+    }
+    break;
+    default:;
+    }
+  }
+
+  if (submit_name != NULL)
+  { // client: niente collector ne' threadpool, i file vengono calcolati dal server
+    // il job contiene i file passati come argomento e la directory passata con -d
+    int npaths = 0;
+    char **paths = malloc(sizeof(char *) * (argc - optind + 1));
+    if (paths == NULL)
+    {
+      perror("malloc");
+      return EXIT_FAILURE;
+    }
+    for (int index = optind; index < argc; index++)
+      paths[npaths++] = argv[index];
+    if (dir_name != NULL)
+      paths[npaths++] = dir_name;
+    int r = serverSubmit(submit_name, paths, npaths);
+    free(paths);
+    if (r == -1)
+    {
+      perror("serverSubmit");
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
 
-  if (pid == 0)
+  // con --resume carico i file gia' calcolati prima di iniziare a sottomettere
+  if (resume && journal_name == NULL)
+  {
+    fprintf(stderr, "l'opzione --resume richiede il journal (--journal), la ignoro\n");
+    resume = 0;
+  }
+  if (resume && journalSkipLoad(journal_name) == -1)
+  {
+    perror(journal_name);
+    return EXIT_FAILURE;
+  }
+
+  // il collector segnala su questa pipe che il socket e' in ascolto: la farm non deve riprovare la connect
+  int ready[2] = {-1, -1};
+  if (!inproc && pipe(ready) == -1)
+  {
+    perror("pipe");
+    return EXIT_FAILURE;
+  }
+
+  // con il collector interno non c'e' nessun processo figlio
+  pid_t pid = -1;
+
+  if (!inproc && (pid = fork()) == 0)
   { // figlio
-    char *argv_for_program[] = {"collector", NULL};
+    close(ready[0]);
+    char readyfd[16];
+    snprintf(readyfd, sizeof(readyfd), "%d", ready[1]);
+    char *argv_for_program[8] = {"collector", "-r", readyfd};
+    int argn = 3;
+    if (append_mode)
+      argv_for_program[argn++] = "-a";
+    if (journal_name != NULL)
+    {
+      argv_for_program[argn++] = "-j";
+      argv_for_program[argn++] = journal_name;
+    }
+    if (resume)
+      argv_for_program[argn++] = "-R";
+    argv_for_program[argn] = NULL;
     if (execvp("./collector", argv_for_program) == -1)
     {
       perror("execvp");
@@ -284,30 +853,54 @@ int main(int argc, char *argv[])
   }
   else
   { // padre
-    if (pid == -1)
+    if (!inproc && pid == -1)
     { // errore padre
       perror("fork");
       return EXIT_FAILURE;
     }
 
-    // creo e connetto il socket
-    struct sockaddr_un serv_addr;
-    SYSCALL_EXIT("socket", serverfd, socket(AF_UNIX, SOCK_STREAM, 0), "socket", "");
-    memset(&serv_addr, '0', sizeof(serv_addr));
+    if (inproc)
+    { // avvio il thread collector con i segnali ancora bloccati, cosi' non li riceve
+      if (inprocStart(append_mode, journal_name, resume) == -1)
+      {
+        perror("inprocStart");
+        return EXIT_FAILURE;
+      }
+      protocol = PROTO_INPROC; // i worker non si connettono al socket
+    }
+    else
+    {
+      // attendo che il collector sia in ascolto: se termina prima, la pipe viene chiusa senza dati
+      close(ready[1]);
+      char ok;
+      ssize_t n;
+      while ((n = read(ready[0], &ok, 1)) == -1 && errno == EINTR)
+        ;
+      close(ready[0]);
+      if (n != 1)
+      {
+        fprintf(stderr, "il collector non e' partito\n");
+        waitpid(pid, NULL, 0);
+        return EXIT_FAILURE;
+      }
 
-    serv_addr.sun_family = AF_UNIX;
-    strncpy(serv_addr.sun_path, SOCKNAME, UNIX_PATH_MAX);
-    // printf("%s\n",serv_addr.sun_path );
+      // creo e connetto il socket
+      struct sockaddr_un serv_addr;
+      SYSCALL_EXIT("socket", serverfd, socket(AF_UNIX, SOCK_STREAM, 0), "socket", "");
+      memset(&serv_addr, '0', sizeof(serv_addr));
 
-    // connetto il socket
-    while (connect(serverfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == -1)
-    {
-      if (errno == ENOENT)
-        msleep(50); /* sock non esiste */
-      else
+      serv_addr.sun_family = AF_UNIX;
+      strncpy(serv_addr.sun_path, SOCKNAME, UNIX_PATH_MAX);
+      // printf("%s\n",serv_addr.sun_path );
+
+      // connetto il socket, che esiste gia'
+      if (connect(serverfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == -1)
+      {
+        perror("connect");
         exit(EXIT_FAILURE);
+      }
+      // socket connesso
     }
-    // socket connesso
 
     // installo il signal handler per tutti i segnali che mi interessano
     struct sigaction sa;
@@ -331,46 +924,6 @@ int main(int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-    // setto i valori di default
-    long nthread = NTHREAD, qlen = QLEN, delay = DELAY;
-
-    char *dir_name = NULL;
-
-    int opt;
-
-    while ((opt = getopt(argc, argv, ":n:q:t:d:h:")) != -1)
-    {
-      switch (opt)
-      {
-      case 'n':
-        arg_n(optarg, &nthread);
-        break;
-      case 'q':
-        arg_q(optarg, &qlen);
-        break;
-      case 't':
-        arg_t(optarg, &delay);
-        break;
-      case 'd':
-        arg_d(optarg, &dir_name);
-        break;
-      case 'h':
-        arg_h(argv[0]);
-        break;
-      case ':':
-      { // restituito se manca il valore corrispondente ad un' opzione
-        // printf("l'opzione '-%c' richiede un argomento\n", optopt);
-      }
-      break;
-      case '?':
-      { // restituito se getopt trova una opzione non riconosciuta
-        //  printf("l'opzione '-%c' non e' gestita\n", optopt);
-      }
-      break;
-      default:;
-      }
-    }
-
     /*
     // Stampe di prova
     printf("-n : %ld\n", nthread);
@@ -380,16 +933,49 @@ int main(int argc, char *argv[])
       printf("-d : \"%s\"\n", dir_name);
     */
 
+    // scelgo la variante del kernel di calcolo in base alla CPU
+    wsum_init();
+
+    // apro la cache dei risultati prima di creare il threadpool, i worker vi memorizzano i risultati calcolati
+    if (watch_mode && dir_name == NULL)
+      fprintf(stderr, "l'opzione --watch richiede una directory (-d), la ignoro\n");
+    if (incremental && cache_name == NULL)
+      fprintf(stderr, "l'opzione -i richiede la cache (-C), la ignoro\n");
+    if (cache_name != NULL && rcacheOpen(cache_name, incremental) == -1)
+    {
+      perror("rcacheOpen");
+      fprintf(stderr, "la cache %s non e' utilizzabile, proseguo senza\n", cache_name);
+    }
+
     // creo il threadpool
-    threadpool_t *tp = createThreadPool(nthread, qlen);
+    threadpool_t *tp = createThreadPoolWithProtocol(nthread, qlen, queue_type, protocol);
+    if (tp == NULL)
+    { // il collector e' gia' partito: gli chiedo di terminare prima di uscire
+      perror("createThreadPool");
+      abort_run(NULL, pid);
+      return EXIT_FAILURE;
+    }
     // printf("Threadpool creato\n");
 
-    for (int index = optind; index < argc; index++)
+    // -t distanzia le sottomissioni, --rate-files e --rate-bytes ne limitano la velocita' media concedendo raffiche
+    if ((delay > 0 || files_rate > 0 || bytes_rate > 0) && (pacer = createPacer(files_rate, bytes_rate, delay)) == NULL)
     {
+      perror("createPacer");
+      abort_run(tp, pid);
+      return EXIT_FAILURE;
+    }
 
-      msleep(delay);
-      // printf("dormito per %ld ms\n", delay);
+    // con la politica lpt i file vengono trattenuti e ordinati per dimensione prima di essere sottomessi
+    if (use_lpt && (lpt = createScheduler(window)) == NULL)
+    {
+      perror("createScheduler");
+      destroyPacer(pacer);
+      abort_run(tp, pid);
+      return EXIT_FAILURE;
+    }
 
+    for (int index = optind; index < argc; index++)
+    {
       struct stat statbuf;
       if (stat(argv[index], &statbuf) == -1)
       { // faccio la stat
@@ -399,13 +985,17 @@ int main(int argc, char *argv[])
       }
       if (!termina && S_ISREG(statbuf.st_mode))
       {
-        addToThreadPool(tp, (int (*)(void *, void *))compute, argv[index]);
+        schedule(tp, argv[index], &statbuf);
         // printf("Sottomesso al threadpool file : %s\n", argv[index]);
       }
 
       if (termina)
         break;
     }
+    flush_batch(tp);
+
+    if (list_name != NULL && !termina && read_list(tp, list_name, nul_sep) == -1)
+      perror(list_name);
 
     if (dir_name != NULL && !termina)
     {
@@ -419,11 +1009,55 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
       }
       else
-        find(dir_name, tp, delay);
+      { // esploro la directory in parallelo, la stat dei file serve solo per lpt e per la suddivisione in chunk
+        walkctx_t ctx = {tp};
+        // con --watch l'albero viene osservato prima dell'esplorazione, per non perdere i file creati nel frattempo
+        watcher_t *watch = NULL;
+        if (watch_mode && (watch = watchCreate(dir_name)) == NULL)
+          perror("watchCreate");
+        walker_ops_t ops = {walk_file, walk_dir_done, &ctx, (lpt != NULL || chunk_size > 0 || pacer != NULL || rcacheEnabled()), &termina};
+        if (walkTree(dir_name, (int)nwalker, &ops) == -1)
+          perror("walkTree");
+        if (watch != NULL)
+        { // il threadpool e il collector restano attivi: elaboro i nuovi file fino a un segnale di terminazione
+          walker_ops_t wops = {walk_file, watch_done, &ctx, 1, &termina};
+          watch_done(&ctx);
+          if (watchRun(watch, &wops) == -1)
+            perror("watchRun");
+          watchDestroy(watch);
+        }
+      }
       // printf("iniziata l'esplorazione della cartella %s\n", dir_name);
     }
+    // sottometto i file ancora trattenuti dallo scheduler, dal piu' grande al piu' piccolo
+    if (lpt != NULL)
+    {
+      while (!termina && submit_next(tp) == 0)
+        ;
+      destroyScheduler(lpt);
+    }
+
+    // server di job: il threadpool resta attivo e calcola i file dei job ricevuti fino a un segnale di terminazione
+    if (server_name != NULL && !termina && serverRun(tp, server_name, (int)nwalker, &termina) == -1)
+      perror("serverRun");
+
     // distruggo il threadpool , terminando i task in coda senza accettarne di nuovi 
     destroyThreadPool(tp, 0);
+    serverClose(); // i risultati dei job completati dal pool vengono inviati ai client
+    pathallocCleanup(); // i worker sono terminati, libero gli slab dei pathname
+    rcacheClose();
+    journalSkipFree();
+    destroyPacer(pacer);
+
+    if (inproc)
+    { // i worker hanno consegnato tutti i frame: il collector li memorizza, stampa e termina
+      if (inprocStop() == -1)
+      {
+        perror("inprocStop");
+        exit(EXIT_FAILURE);
+      }
+      exit(EXIT_SUCCESS);
+    }
 
     // invio codice di terminazione al collector
     // utilizzo un' altra connessione
@@ -439,12 +1073,10 @@ int main(int argc, char *argv[])
     // printf("%s\n",serv_addr.sun_path );
 
     // connetto il socket
-    while (connect(serverfd2, (struct sockaddr *)&serv_addr2, sizeof(serv_addr2)) == -1)
+    if (connect(serverfd2, (struct sockaddr *)&serv_addr2, sizeof(serv_addr2)) == -1)
     {
-      if (errno == ENOENT)
-        msleep(50); /* sock non esiste */
-      else
-        exit(EXIT_FAILURE);
+      perror("connect");
+      exit(EXIT_FAILURE);
     }
     // socket connesso
 
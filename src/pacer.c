@@ -0,0 +1,88 @@
+/*********************************/
+//  implementation file pacer.c   /
+/*===============================*/
+
+// include
+#include <util.h>
+#include <pacer.h>
+
+// ns trascorsi da origin
+static double elapsed_ns(const struct timespec *origin)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - origin->tv_sec) * 1e9 + (now.tv_nsec - origin->tv_nsec);
+}
+
+pacer_t *createPacer(double files_rate, double bytes_rate, long interval_ms)
+{
+    pacer_t *p = malloc(sizeof(pacer_t));
+    if (p == NULL)
+        return NULL;
+    int r;
+    if ((r = pthread_mutex_init(&p->lock, NULL)) != 0)
+    {
+        free(p);
+        errno = r;
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &p->origin);
+    p->file_ns = (files_rate > 0) ? 1e9 / files_rate : 0;
+    if (interval_ms * 1e6 > p->file_ns)
+        p->file_ns = interval_ms * 1e6;
+    p->byte_ns = (bytes_rate > 0) ? 1e9 / bytes_rate : 0;
+    // con -t il secchio dei file contiene un solo file: le sottomissioni restano distanziate come con msleep
+    p->file_cap = (interval_ms > 0 || p->file_ns > PACER_BURST_MS * 1e6) ? p->file_ns : PACER_BURST_MS * 1e6;
+    p->byte_cap = PACER_BURST_MS * 1e6;
+    p->file_tat = p->byte_tat = 0;
+    return p;
+}
+
+/**
+ * funzione reserve
+ * @brief addebita cost ns al secchio che torna pieno all'istante *tat e di capacita' cap
+ * @return l'istante da cui il secchio contiene abbastanza credito per il costo
+ */
+static double reserve(double *tat, double cap, double cost, double now)
+{
+    if (*tat < now)
+        *tat = now; // il secchio e' pieno: il credito oltre la capacita' non si accumula
+    *tat += cost;
+    return *tat - cap;
+}
+
+int pacerWait(pacer_t *p, off_t bytes, volatile sig_atomic_t *stop)
+{
+    pthread_mutex_lock(&p->lock);
+    double now = elapsed_ns(&p->origin);
+    double deadline = 0;
+    if (p->file_ns > 0)
+        deadline = reserve(&p->file_tat, p->file_cap, p->file_ns, now);
+    if (p->byte_ns > 0 && bytes > 0)
+    {
+        double at = reserve(&p->byte_tat, p->byte_cap, bytes * p->byte_ns, now);
+        if (at > deadline)
+            deadline = at;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    // attendo la scadenza assoluta senza lock, a intervalli di al piu' PACER_POLL_MS per controllare stop
+    while ((now = elapsed_ns(&p->origin)) < deadline)
+    {
+        if (stop != NULL && *stop)
+            return 1;
+        double until = (deadline - now > PACER_POLL_MS * 1e6) ? now + PACER_POLL_MS * 1e6 : deadline;
+        long long ns = p->origin.tv_nsec + (long long)until;
+        struct timespec ts = {p->origin.tv_sec + (time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    return (stop != NULL && *stop) ? 1 : 0;
+}
+
+void destroyPacer(pacer_t *p)
+{
+    if (p == NULL)
+        return;
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
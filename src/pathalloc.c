@@ -0,0 +1,194 @@
+/*************************************/
+//  implementation file pathalloc.c   /
+/*===================================*/
+
+// include
+#include <util.h>
+#include <pthread.h>
+#include <pathalloc.h>
+
+// classi di dimensione: la classe c contiene blocchi da (32 << c) byte, l'ultima da 4096 byte (PATH_MAX)
+#define PATHALLOC_MIN_SHIFT 5
+#define PATHALLOC_CLASSES 8
+// classe dei blocchi piu' grandi dell'ultima classe, allocati e liberati direttamente con malloc/free
+#define PATHALLOC_BIG PATHALLOC_CLASSES
+// dimensione di uno slab da cui vengono ritagliati i blocchi
+#define PATHALLOC_SLAB (64 * 1024)
+// numero di blocchi scambiati in una volta tra la lista di un thread e il deposito globale
+#define PATHALLOC_BATCH 32
+// numero massimo di blocchi liberi per classe trattenuti da un thread
+#define PATHALLOC_CACHE_MAX (2 * PATHALLOC_BATCH)
+
+// intestazione di un blocco, seguita dai byte restituiti all'utente
+typedef struct pathblock_t
+{
+    struct pathblock_t *next; // blocco successivo nella lista dei liberi
+    long cls;                 // classe di dimensione del blocco
+} pathblock_t;
+
+// intestazione di uno slab, gli slab sono tenuti in una lista per liberarli alla fine
+typedef struct slab_t
+{
+    struct slab_t *next;
+    long pad; // mantiene i blocchi allineati come l'intestazione
+} slab_t;
+
+// blocchi liberi del thread corrente, per classe
+static __thread pathblock_t *cache[PATHALLOC_CLASSES];
+static __thread int cached[PATHALLOC_CLASSES];
+
+// deposito globale dei blocchi liberi e lista degli slab
+static pthread_mutex_t depot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pathblock_t *depot[PATHALLOC_CLASSES];
+static slab_t *slabs = NULL;
+
+static size_t class_size(int cls)
+{
+    return (size_t)1 << (cls + PATHALLOC_MIN_SHIFT);
+}
+
+// classe piu' piccola con blocchi di almeno size byte, PATHALLOC_BIG se nessuna classe basta
+static int size_class(size_t size)
+{
+    int cls = 0;
+    while (cls < PATHALLOC_CLASSES && class_size(cls) < size)
+        cls++;
+    return cls;
+}
+
+// riempie la lista vuota della classe cls con un lotto preso dal deposito o, se il deposito e' vuoto, con un nuovo slab
+static int refill(int cls)
+{
+    pthread_mutex_lock(&depot_lock);
+    pathblock_t *first = depot[cls];
+    if (first != NULL)
+    {
+        pathblock_t *last = first;
+        int n = 1;
+        while (n < PATHALLOC_BATCH && last->next != NULL)
+        {
+            last = last->next;
+            n++;
+        }
+        depot[cls] = last->next;
+        pthread_mutex_unlock(&depot_lock);
+        last->next = NULL;
+        cache[cls] = first;
+        cached[cls] = n;
+        return 0;
+    }
+    pthread_mutex_unlock(&depot_lock);
+
+    slab_t *slab = malloc(PATHALLOC_SLAB);
+    if (slab == NULL)
+        return -1;
+    size_t bsize = sizeof(pathblock_t) + class_size(cls);
+    size_t n = (PATHALLOC_SLAB - sizeof(slab_t)) / bsize;
+    char *p = (char *)(slab + 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        pathblock_t *blk = (pathblock_t *)(p + i * bsize);
+        blk->cls = cls;
+        blk->next = cache[cls];
+        cache[cls] = blk;
+    }
+    cached[cls] = (int)n;
+
+    pthread_mutex_lock(&depot_lock);
+    slab->next = slabs;
+    slabs = slab;
+    pthread_mutex_unlock(&depot_lock);
+    return 0;
+}
+
+void *pathAlloc(size_t size)
+{
+    int cls = size_class(size);
+    pathblock_t *blk;
+    if (cls == PATHALLOC_BIG)
+    {
+        if ((blk = malloc(sizeof(pathblock_t) + size)) == NULL)
+            return NULL;
+        blk->cls = PATHALLOC_BIG;
+        return blk + 1;
+    }
+    if (cache[cls] == NULL && refill(cls) == -1)
+        return NULL;
+    blk = cache[cls];
+    cache[cls] = blk->next;
+    cached[cls]--;
+    return blk + 1;
+}
+
+char *pathDup(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *p = pathAlloc(len);
+    if (p != NULL)
+        memcpy(p, s, len);
+    return p;
+}
+
+void pathFree(void *p)
+{
+    if (p == NULL)
+        return;
+    pathblock_t *blk = (pathblock_t *)p - 1;
+    int cls = (int)blk->cls;
+    if (cls == PATHALLOC_BIG)
+    {
+        free(blk);
+        return;
+    }
+    blk->next = cache[cls];
+    cache[cls] = blk;
+    if (++cached[cls] <= PATHALLOC_CACHE_MAX)
+        return;
+
+    // troppi blocchi liberi: ne restituisco un lotto al deposito, dove li riprende chi alloca
+    pathblock_t *first = cache[cls], *last = first;
+    for (int i = 1; i < PATHALLOC_BATCH; i++)
+        last = last->next;
+    cache[cls] = last->next;
+    cached[cls] -= PATHALLOC_BATCH;
+    pthread_mutex_lock(&depot_lock);
+    last->next = depot[cls];
+    depot[cls] = first;
+    pthread_mutex_unlock(&depot_lock);
+}
+
+void pathallocThreadFlush(void)
+{
+    for (int cls = 0; cls < PATHALLOC_CLASSES; cls++)
+    {
+        pathblock_t *first = cache[cls], *last = first;
+        if (first == NULL)
+            continue;
+        while (last->next != NULL)
+            last = last->next;
+        pthread_mutex_lock(&depot_lock);
+        last->next = depot[cls];
+        depot[cls] = first;
+        pthread_mutex_unlock(&depot_lock);
+        cache[cls] = NULL;
+        cached[cls] = 0;
+    }
+}
+
+void pathallocCleanup(void)
+{
+    pthread_mutex_lock(&depot_lock);
+    while (slabs != NULL)
+    {
+        slab_t *next = slabs->next;
+        free(slabs);
+        slabs = next;
+    }
+    for (int cls = 0; cls < PATHALLOC_CLASSES; cls++)
+    {
+        depot[cls] = NULL;
+        cache[cls] = NULL;
+        cached[cls] = 0;
+    }
+    pthread_mutex_unlock(&depot_lock);
+}
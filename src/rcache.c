@@ -0,0 +1,285 @@
+/*********************************/
+//  implementation file rcache.c  /
+/*===============================*/
+
+#define _GNU_SOURCE // flock non fa parte di POSIX
+
+// include
+#include <util.h>
+#include <rcache.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+
+// identifica un file di cache valido (formato versione 1)
+#define RCACHE_MAGIC "FARMRC1"
+// numero di elementi di una cache nuova (potenza di 2)
+#define RCACHE_MIN_SLOTS 1024
+
+/**
+ *  @struct rcslot_t
+ *  @brief elemento della tabella, 64 byte per non dividere un elemento tra due linee di cache
+ *
+ *  @var key    chiave del file
+ *  @var result risultato del file
+ *  @var used   1 se l'elemento e' occupato
+ *  @var check  controllo dei primi e degli ultimi long del file (rcacheCheck), 0 se non e' noto
+ */
+typedef struct rcslot_t
+{
+    rckey_t key;
+    long result;
+    long used;
+    unsigned long check;
+} rcslot_t;
+
+/**
+ *  @struct rchdr_t
+ *  @brief intestazione del file della cache, seguita da nslots elementi
+ *
+ *  @var magic  RCACHE_MAGIC
+ *  @var nslots numero di elementi della tabella (potenza di 2)
+ *  @var count  numero di elementi occupati
+ */
+typedef struct rchdr_t
+{
+    char magic[8];
+    unsigned long nslots;
+    unsigned long count;
+    long pad[5];
+} rchdr_t;
+
+static pthread_mutex_t rc_lock = PTHREAD_MUTEX_INITIALIZER;
+static int rc_fd = -1;
+static int rc_incremental = 0;
+static rchdr_t *rc_hdr = NULL; // intestazione mappata, NULL se la cache non e' aperta
+static rcslot_t *rc_slots = NULL;
+
+// dimensione del file di una cache di nslots elementi
+static size_t rc_filesize(unsigned long nslots)
+{
+    return sizeof(rchdr_t) + nslots * sizeof(rcslot_t);
+}
+
+// posizione iniziale della scansione per il file (dev, ino)
+static unsigned long rc_hash(const rckey_t *key)
+{
+    unsigned long h = key->ino * 0x9E3779B97F4A7C15UL ^ key->dev;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9UL;
+    return h ^ (h >> 32);
+}
+
+// elemento del file (dev, ino) oppure primo elemento libero della sua scansione
+static rcslot_t *rc_find(const rckey_t *key)
+{
+    unsigned long mask = rc_hdr->nslots - 1;
+    for (unsigned long i = rc_hash(key) & mask;; i = (i + 1) & mask)
+    {
+        rcslot_t *s = &rc_slots[i];
+        if (!s->used || (s->key.dev == key->dev && s->key.ino == key->ino))
+            return s;
+    }
+}
+
+// mappa il file della cache di nslots elementi
+static int rc_map(unsigned long nslots)
+{
+    void *p = mmap(NULL, rc_filesize(nslots), PROT_READ | PROT_WRITE, MAP_SHARED, rc_fd, 0);
+    if (p == MAP_FAILED)
+        return -1;
+    rc_hdr = (rchdr_t *)p;
+    rc_slots = (rcslot_t *)(rc_hdr + 1);
+    return 0;
+}
+
+// porta il file a una cache vuota di nslots elementi e la mappa
+static int rc_reset(unsigned long nslots)
+{
+    // ftruncate a 0 azzera anche gli elementi gia' presenti nel file
+    if (ftruncate(rc_fd, 0) == -1 || ftruncate(rc_fd, rc_filesize(nslots)) == -1 || rc_map(nslots) == -1)
+        return -1;
+    memcpy(rc_hdr->magic, RCACHE_MAGIC, sizeof(rc_hdr->magic));
+    rc_hdr->nslots = nslots;
+    rc_hdr->count = 0;
+    return 0;
+}
+
+// raddoppia la tabella reinserendo gli elementi occupati, chiamata con rc_lock acquisita
+static int rc_grow(void)
+{
+    unsigned long nslots = rc_hdr->nslots;
+    size_t size = nslots * sizeof(rcslot_t);
+    rcslot_t *old = malloc(size);
+    if (old == NULL)
+        return -1;
+    memcpy(old, rc_slots, size);
+    munmap(rc_hdr, rc_filesize(nslots));
+    rc_hdr = NULL;
+    if (rc_reset(nslots * 2) == -1)
+    { // la cache viene disattivata, il file verra' reinizializzato alla prossima apertura
+        free(old);
+        return -1;
+    }
+    for (unsigned long i = 0; i < nslots; i++)
+        if (old[i].used)
+        {
+            *rc_find(&old[i].key) = old[i];
+            rc_hdr->count++;
+        }
+    free(old);
+    return 0;
+}
+
+int rcacheOpen(const char *path, int incremental)
+{
+    rc_incremental = incremental;
+    if ((rc_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) == -1)
+        return -1;
+    // un'altra farm sta usando la cache
+    if (flock(rc_fd, LOCK_EX | LOCK_NB) == -1)
+    {
+        close(rc_fd);
+        rc_fd = -1;
+        return -1;
+    }
+
+    struct stat st;
+    rchdr_t hdr;
+    int valid = fstat(rc_fd, &st) == 0 && st.st_size >= (off_t)sizeof(rchdr_t) &&
+                pread(rc_fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+                memcmp(hdr.magic, RCACHE_MAGIC, sizeof(hdr.magic)) == 0 &&
+                hdr.nslots >= RCACHE_MIN_SLOTS && (hdr.nslots & (hdr.nslots - 1)) == 0 &&
+                st.st_size == (off_t)rc_filesize(hdr.nslots) && hdr.count < hdr.nslots;
+    if ((valid ? rc_map(hdr.nslots) : rc_reset(RCACHE_MIN_SLOTS)) == -1)
+    {
+        int errtemp = errno;
+        close(rc_fd);
+        rc_fd = -1;
+        rc_hdr = NULL;
+        errno = errtemp;
+        return -1;
+    }
+    return 0;
+}
+
+int rcacheEnabled(void)
+{
+    return rc_fd != -1;
+}
+
+int rcacheIncremental(void)
+{
+    return rc_fd != -1 && rc_incremental;
+}
+
+void rcacheKey(const struct stat *st, rckey_t *key)
+{
+    key->dev = (unsigned long)st->st_dev;
+    key->ino = (unsigned long)st->st_ino;
+    key->size = (long)st->st_size;
+    key->sec = (long)st->st_mtim.tv_sec;
+    key->nsec = (long)st->st_mtim.tv_nsec;
+}
+
+int rcacheLookup(const rckey_t *key, long *result)
+{
+    int hit = 0;
+    pthread_mutex_lock(&rc_lock);
+    if (rc_hdr != NULL)
+    {
+        rcslot_t *s = rc_find(key);
+        if (s->used && s->key.size == key->size && s->key.sec == key->sec && s->key.nsec == key->nsec)
+        {
+            *result = s->result;
+            hit = 1;
+        }
+    }
+    pthread_mutex_unlock(&rc_lock);
+    return hit;
+}
+
+int rcachePrefix(const rckey_t *key, long *size, long *result, unsigned long *check)
+{
+    int found = 0;
+    pthread_mutex_lock(&rc_lock);
+    if (rc_hdr != NULL && rc_incremental)
+    {
+        rcslot_t *s = rc_find(key);
+        if (s->used && s->check != 0 && s->key.size < key->size)
+        {
+            *size = s->key.size;
+            *result = s->result;
+            *check = s->check;
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&rc_lock);
+    return found;
+}
+
+// legge n long del file a partire dal long first e li mescola in h (FNV-1a), -1 se la lettura fallisce
+static int check_range(int fd, long first, long n, unsigned long *h)
+{
+    long buf[RCACHE_CHECK_LONGS];
+    size_t len = n * sizeof(long);
+    ssize_t r;
+    while ((r = pread(fd, buf, len, (off_t)first * sizeof(long))) == -1 && errno == EINTR)
+        ;
+    if (r != (ssize_t)len)
+        return -1;
+    const unsigned char *p = (const unsigned char *)buf;
+    for (size_t i = 0; i < len; i++)
+        *h = (*h ^ p[i]) * 0x100000001B3UL;
+    return 0;
+}
+
+unsigned long rcacheCheck(int fd, long nelem)
+{
+    if (nelem == 0)
+        return 0;
+    // FNV-1a sui primi e sugli ultimi long del prefisso, mescolato con il numero di long del prefisso
+    unsigned long h = 0xCBF29CE484222325UL ^ (unsigned long)nelem;
+    long head = nelem < RCACHE_CHECK_LONGS ? nelem : RCACHE_CHECK_LONGS;
+    if (check_range(fd, 0, head, &h) == -1)
+        return 0;
+    long tail = nelem - head < RCACHE_CHECK_LONGS ? nelem - head : RCACHE_CHECK_LONGS;
+    if (tail > 0 && check_range(fd, nelem - tail, tail, &h) == -1)
+        return 0;
+    return h != 0 ? h : 1;
+}
+
+void rcacheStore(const rckey_t *key, long result, unsigned long check)
+{
+    pthread_mutex_lock(&rc_lock);
+    // la tabella resta piena al piu' per meta', per avere scansioni brevi
+    if (rc_hdr != NULL && 2 * (rc_hdr->count + 1) > rc_hdr->nslots && rc_grow() == -1)
+        perror("rcacheStore");
+    if (rc_hdr != NULL)
+    {
+        rcslot_t *s = rc_find(key);
+        if (!s->used)
+            rc_hdr->count++;
+        s->key = *key;
+        s->result = result;
+        s->used = 1;
+        s->check = check;
+    }
+    pthread_mutex_unlock(&rc_lock);
+}
+
+void rcacheClose(void)
+{
+    pthread_mutex_lock(&rc_lock);
+    if (rc_hdr != NULL)
+    {
+        // le pagine modificate di una mappatura MAP_SHARED vengono scritte nel file dal kernel, anche dopo munmap
+        munmap(rc_hdr, rc_filesize(rc_hdr->nslots));
+        rc_hdr = NULL;
+    }
+    if (rc_fd != -1)
+        close(rc_fd); // rilascia anche il flock
+    rc_fd = -1;
+    pthread_mutex_unlock(&rc_lock);
+}
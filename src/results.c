@@ -0,0 +1,119 @@
+/**********************************/
+//  implementation file results.c  /
+/*================================*/
+
+// include
+#include <util.h>
+#include <results.h>
+#include <sortedlist.h>
+#include <resultarray.h>
+#include <journal.h>
+
+int resultsInit(results_t *res, int append_mode)
+{
+    res->list = NULL;
+    res->array = NULL;
+    res->journal = NULL;
+    if (append_mode)
+        res->array = newArray();
+    else
+        res->list = newList(); // lista ordinata dei risultati
+    return (res->list == NULL && res->array == NULL) ? -1 : 0;
+}
+
+// ricarica un risultato del journal
+static int reload(long result, const char *filename, void *arg)
+{
+    return resultsStore(arg, result, (char *)filename);
+}
+
+int resultsJournal(results_t *res, const char *path, int resume)
+{
+    journal_t *j = malloc(sizeof(journal_t));
+    if (j == NULL)
+        return -1;
+    // il journal viene assegnato solo dopo il caricamento, per non riaccodare i risultati ricaricati
+    if ((resume && journalLoad(path, reload, res) == -1) || journalOpen(j, path, resume) == -1)
+    {
+        int errtemp = errno;
+        free(j);
+        errno = errtemp;
+        return -1;
+    }
+    res->journal = j;
+    return 0;
+}
+
+int resultsStore(results_t *res, long result, char *filename)
+{
+    if (res->journal != NULL && journalAppend(res->journal, result, filename) == -1)
+        return -1;
+    if (res->array != NULL)
+        return appendResult(res->array, result, filename);
+    return insertion_sort(res->list, result, filename);
+}
+
+int resultsStoreFrame(results_t *res, char *p, size_t len)
+{
+    while (len > 0)
+    {
+        long result, length;
+        if (len < 2 * sizeof(long))
+            return -1;
+        memcpy(&result, p, sizeof(long));
+        memcpy(&length, p + sizeof(long), sizeof(long));
+        p += 2 * sizeof(long);
+        len -= 2 * sizeof(long);
+        if (length <= 0 || length > PATH_MAX || (size_t)length > len)
+            return -1;
+        p[length - 1] = '\0';
+        if (resultsStore(res, result, p) == -1)
+        {
+            perror("resultsStore");
+            return -1;
+        }
+        p += length;
+        len -= length;
+    }
+    return 0;
+}
+
+int resultsSync(results_t *res)
+{
+    return res->journal != NULL ? journalSync(res->journal, 0) : -1;
+}
+
+// l'array viene ordinato solo adesso
+void resultsWrite(results_t *res, FILE *out)
+{
+    if (res->array != NULL)
+    {
+        if (sortArray(res->array) == -1)
+            perror("sortArray");
+        printArray(res->array, out);
+    }
+    else
+        printList(res->list, out);
+    fflush(out);
+}
+
+void resultsPrint(results_t *res)
+{
+    resultsWrite(res, stdout);
+}
+
+void resultsFree(results_t *res)
+{
+    if (res->array != NULL)
+        free_array(res->array);
+    if (res->list != NULL)
+        free_list(res->list);
+    if (res->journal != NULL)
+    {
+        journalClose(res->journal);
+        free(res->journal);
+    }
+    res->list = NULL;
+    res->array = NULL;
+    res->journal = NULL;
+}
@@ -0,0 +1,102 @@
+/*************************************/
+//  implementation file scheduler.c   /
+/*===================================*/
+
+// include
+#include <util.h>
+#include <scheduler.h>
+
+// capacita' iniziale dell'heap
+#define SCHED_INIT_CAP 64
+
+// scambia due elementi dell'heap
+static void swap(sched_item_t *a, sched_item_t *b)
+{
+    sched_item_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+scheduler_t *createScheduler(size_t window)
+{
+    scheduler_t *s = malloc(sizeof(scheduler_t));
+    if (s == NULL)
+        return NULL;
+    s->cap = (window > 0 && window < SCHED_INIT_CAP) ? window + 1 : SCHED_INIT_CAP;
+    s->heap = malloc(sizeof(sched_item_t) * s->cap);
+    if (s->heap == NULL)
+    {
+        free(s);
+        return NULL;
+    }
+    s->count = 0;
+    s->window = window;
+    return s;
+}
+
+int schedPush(scheduler_t *s, const char *file_name, const struct stat *st)
+{
+    if (s->count == s->cap)
+    { // raddoppio la capacita' dell'array
+        sched_item_t *tmp = realloc(s->heap, sizeof(sched_item_t) * s->cap * 2);
+        if (tmp == NULL)
+            return -1;
+        s->heap = tmp;
+        s->cap *= 2;
+    }
+
+    sched_item_t *item = &s->heap[s->count];
+    if ((item->file_name = malloc(strlen(file_name) + 1)) == NULL)
+        return -1;
+    strcpy(item->file_name, file_name);
+    item->st = *st;
+
+    // risalgo finche' il padre e' piu' piccolo
+    size_t i = s->count++;
+    while (i > 0 && s->heap[(i - 1) / 2].st.st_size < s->heap[i].st.st_size)
+    {
+        swap(&s->heap[(i - 1) / 2], &s->heap[i]);
+        i = (i - 1) / 2;
+    }
+    return 0;
+}
+
+int schedFull(const scheduler_t *s)
+{
+    return s->window > 0 && s->count > s->window;
+}
+
+int schedPop(scheduler_t *s, sched_item_t *item)
+{
+    if (s->count == 0)
+        return -1;
+
+    *item = s->heap[0];
+    s->heap[0] = s->heap[--s->count];
+
+    // scendo verso il figlio piu' grande finche' l'ordine dell'heap non e' ripristinato
+    size_t i = 0;
+    for (;;)
+    {
+        size_t max = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < s->count && s->heap[l].st.st_size > s->heap[max].st.st_size)
+            max = l;
+        if (r < s->count && s->heap[r].st.st_size > s->heap[max].st.st_size)
+            max = r;
+        if (max == i)
+            break;
+        swap(&s->heap[i], &s->heap[max]);
+        i = max;
+    }
+    return 0;
+}
+
+void destroyScheduler(scheduler_t *s)
+{
+    if (s == NULL)
+        return;
+    for (size_t i = 0; i < s->count; i++)
+        free(s->heap[i].file_name);
+    free(s->heap);
+    free(s);
+}
@@ -0,0 +1,322 @@
+/**********************************/
+//  implementation file sender.c   /
+/*================================*/
+
+// include
+#include <util.h>
+#include <communication.h>
+#include <sender.h>
+#include <inproc.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+// scrive tutti i byte descritti da iov, riprendendo dopo le scritture parziali
+static int writevn(int fd, struct iovec *iov, int cnt)
+{
+    while (cnt > 0)
+    {
+        ssize_t r = writev(fd, iov, cnt);
+        if (r == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        // salto i buffer scritti per intero e avanzo nel primo scritto in parte
+        while (cnt > 0 && (size_t)r >= iov->iov_len)
+        {
+            r -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + r;
+            iov->iov_len -= r;
+        }
+    }
+    return 0;
+}
+
+// millisecondi trascorsi da t
+static long elapsed_ms(const struct timespec *t)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - t->tv_sec) * 1000 + (now.tv_nsec - t->tv_nsec) / 1000000;
+}
+
+// sender che accodano record, controllati dal thread di servizio
+static pthread_mutex_t reg_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reg_cond;
+static sender_t *reg_head = NULL;
+static pthread_once_t reg_once = PTHREAD_ONCE_INIT;
+
+static int flush_locked(sender_t *s);
+
+static int pending_locked(const sender_t *s)
+{
+    if (s->version == PROTO_V3)
+        return ringUnnotified(&s->ring) > 0;
+    return s->len > 0;
+}
+
+/**
+ * funzione flusher
+ * @brief thread di servizio: ogni SENDER_TICK ms invia i record dei sender che li trattengono da almeno
+ *        SENDER_MAX_DELAY - SENDER_TICK ms, cosi' nessun record aspetta piu' di SENDER_MAX_DELAY ms anche se
+ *        il suo worker e' occupato. Un sender il cui worker sta accodando un record viene saltato: il worker
+ *        controlla la scadenza da solo
+ */
+static void *flusher(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&reg_lock);
+    for (;;)
+    {
+        while (reg_head == NULL)
+            pthread_cond_wait(&reg_cond, &reg_lock);
+        for (sender_t *s = reg_head; s != NULL; s = s->next)
+        {
+            if (pthread_mutex_trylock(&s->lock) != 0)
+                continue;
+            if (pending_locked(s) && elapsed_ms(&s->oldest) >= SENDER_MAX_DELAY - SENDER_TICK)
+                flush_locked(s); // in caso di errore i record vengono scartati, come con senderFlush
+            pthread_mutex_unlock(&s->lock);
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += SENDER_TICK * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&reg_cond, &reg_lock, &deadline);
+    }
+    return NULL;
+}
+
+static void flusher_start(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&reg_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, flusher, NULL) == 0)
+        pthread_detach(tid);
+    else // i record partono comunque al record successivo o quando il worker resta senza lavoro
+        perror("pthread_create");
+}
+
+// il sender viene controllato dal thread di servizio
+static void reg_add(sender_t *s)
+{
+    pthread_once(&reg_once, flusher_start);
+    pthread_mutex_lock(&reg_lock);
+    s->next = reg_head;
+    reg_head = s;
+    pthread_cond_signal(&reg_cond);
+    pthread_mutex_unlock(&reg_lock);
+}
+
+static void reg_remove(sender_t *s)
+{
+    pthread_mutex_lock(&reg_lock);
+    for (sender_t **p = &reg_head; *p != NULL; p = &(*p)->next)
+    {
+        if (*p == s)
+        {
+            *p = s->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&reg_lock);
+}
+
+/**
+ * funzione send_ring
+ * @brief crea l'anello del worker e ne invia i descrittori al collector con MSG_RING
+ * @return la versione accettata dal collector (PROTO_V3 o PROTO_V2), -1 in caso di errore
+ */
+static int send_ring(sender_t *s)
+{
+    if (ringCreate(&s->ring) == -1)
+        return PROTO_V2; // senza anello i risultati viaggiano in frame
+
+    long codice = MSG_RING;
+    struct iovec iov = {&codice, sizeof(long)};
+    union
+    { // buffer dei dati ausiliari allineato come una cmsghdr
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * RING_FDS)];
+    } ctl;
+    memset(&ctl, 0, sizeof(ctl));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * RING_FDS);
+    int fds[RING_FDS] = {s->ring.memfd, s->ring.datafd, s->ring.spacefd};
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    long accepted;
+    ssize_t r;
+    while ((r = sendmsg(s->fd, &msg, 0)) == -1 && errno == EINTR)
+        ;
+    if (r != sizeof(long) || readn(s->fd, &accepted, sizeof(long)) != sizeof(long))
+    {
+        ringDestroy(&s->ring);
+        return -1;
+    }
+    if (accepted != PROTO_V3)
+        ringDestroy(&s->ring);
+    return (int)accepted;
+}
+
+int senderInit(sender_t *s, int fd, int version)
+{
+    s->fd = fd;
+    s->version = PROTO_V1;
+    s->buf = NULL;
+    s->len = 0;
+    s->next = NULL;
+    pthread_mutex_init(&s->lock, NULL);
+    s->ring.hdr = NULL;
+    s->ring.memfd = s->ring.datafd = s->ring.spacefd = -1;
+    if (version == PROTO_INPROC)
+    { // collector interno: nessun socket, il buffer viene allocato al primo record
+        s->fd = -1;
+        s->version = PROTO_INPROC;
+        reg_add(s);
+        return 0;
+    }
+    if (version < PROTO_V2)
+        return 0; // versione 1: nessun handshake
+
+    long hello[2] = {MSG_HELLO, version};
+    long accepted;
+    if (writen(fd, hello, sizeof(hello)) != 1 || readn(fd, &accepted, sizeof(long)) != sizeof(long))
+        return -1;
+    if (accepted < PROTO_V1 || accepted > version)
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    if (accepted == PROTO_V3 && (accepted = send_ring(s)) == -1)
+        return -1;
+    if (accepted != PROTO_V2 && accepted != PROTO_V3 && accepted != PROTO_V1)
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    s->version = (int)accepted;
+    if (s->version == PROTO_V2 && (s->buf = malloc(SENDER_FRAME)) == NULL)
+        return -1;
+    if (s->version != PROTO_V1) // con la versione 1 non ci sono record in attesa
+        reg_add(s);
+    return 0;
+}
+
+static int put_locked(sender_t *s, long result, const char *name)
+{
+    if (s->version == PROTO_V3)
+    { // il collector viene svegliato quando i record non segnalati occupano un ottavo dell'anello o aspettano da troppo
+        if (ringUnnotified(&s->ring) == 0)
+            clock_gettime(CLOCK_MONOTONIC, &s->oldest);
+        if (ringPut(&s->ring, result, name) == -1)
+            return -1;
+        if (ringUnnotified(&s->ring) >= RING_SIZE / 8 || elapsed_ms(&s->oldest) >= SENDER_MAX_DELAY)
+            ringNotify(&s->ring);
+        return 0;
+    }
+
+    long length = strlen(name) + 1; // lunghezza del pathname compreso il '\0'
+    if (s->version == PROTO_V1)
+    {
+        long head[3] = {MSG_RESULT, result, length};
+        struct iovec iov[2] = {{head, sizeof(head)}, {(void *)name, length}};
+        return writevn(s->fd, iov, 2);
+    }
+
+    size_t size = 2 * sizeof(long) + length;
+    if (s->len + size > SENDER_FRAME && flush_locked(s) == -1)
+        return -1;
+    if (s->buf == NULL && (s->buf = malloc(SENDER_FRAME)) == NULL)
+        return -1; // il frame precedente e' passato al collector interno
+    if (s->len == 0)
+        clock_gettime(CLOCK_MONOTONIC, &s->oldest);
+    memcpy(s->buf + s->len, &result, sizeof(long));
+    memcpy(s->buf + s->len + sizeof(long), &length, sizeof(long));
+    memcpy(s->buf + s->len + 2 * sizeof(long), name, length);
+    s->len += size;
+
+    // il frame parte se non c'e' spazio per un altro record lungo o se il primo record aspetta da troppo
+    if (s->len + 2 * sizeof(long) + PATH_MAX > SENDER_FRAME || elapsed_ms(&s->oldest) >= SENDER_MAX_DELAY)
+        return flush_locked(s);
+    return 0;
+}
+
+int senderPut(sender_t *s, long result, const char *name)
+{
+    pthread_mutex_lock(&s->lock);
+    int r = put_locked(s, result, name);
+    pthread_mutex_unlock(&s->lock);
+    return r;
+}
+
+int senderPending(sender_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    int r = pending_locked(s);
+    pthread_mutex_unlock(&s->lock);
+    return r;
+}
+
+static int flush_locked(sender_t *s)
+{
+    if (s->version == PROTO_V3)
+    {
+        ringNotify(&s->ring);
+        return 0;
+    }
+    if (s->len == 0)
+        return 0;
+    if (s->version == PROTO_INPROC)
+    { // il buffer passa al collector interno
+        char *frame = s->buf;
+        size_t len = s->len;
+        s->buf = NULL;
+        s->len = 0;
+        return inprocPush(frame, len);
+    }
+    long head[2] = {MSG_FRAME, (long)s->len};
+    struct iovec iov[2] = {{head, sizeof(head)}, {s->buf, s->len}};
+    s->len = 0;
+    return writevn(s->fd, iov, 2);
+}
+
+int senderFlush(sender_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    int r = flush_locked(s);
+    pthread_mutex_unlock(&s->lock);
+    return r;
+}
+
+void senderClose(sender_t *s)
+{
+    reg_remove(s);
+    senderFlush(s);
+    free(s->buf);
+    s->buf = NULL;
+    ringDestroy(&s->ring);
+    pthread_mutex_destroy(&s->lock);
+}
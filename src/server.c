@@ -0,0 +1,764 @@
+/*********************************/
+//  implementation file server.c  /
+/*===============================*/
+
+#define _GNU_SOURCE // getline e dprintf
+
+// include
+#include <util.h>
+#include <server.h>
+#include <communication.h>
+#include <worker.h>
+#include <walker.h>
+#include <results.h>
+#include <pathalloc.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+/**
+ *  @struct jobfile_t
+ *  @brief file di un job in attesa di essere sottomesso
+ *
+ *  @var path pathname usato per aprire il file (assoluto se il client ne ha indicato uno relativo)
+ *  @var skip byte iniziali di path da saltare per ottenere il pathname indicato dal client
+ */
+typedef struct jobfile_t
+{
+    char *path;
+    int skip;
+} jobfile_t;
+
+/**
+ *  @struct job_t
+ *  @brief job di un client
+ *
+ *  @var next    job successivo nella coda del dispatcher
+ *  @var id      identificatore del job
+ *  @var fd      connessione del client, riceve i risultati
+ *  @var lock    mutua esclusione su res, pending e sull'inserimento dei file
+ *  @var res     risultati del job
+ *  @var pending file sottomessi e non ancora calcolati, piu' uno finche' il dispatcher non ha sottomesso tutti i file
+ *  @var files   file del job
+ *  @var nfiles  numero di file
+ *  @var cap     dimensione di files
+ *  @var first   primo file non ancora sottomesso
+ */
+typedef struct job_t
+{
+    struct job_t *next;
+    long id;
+    int fd;
+    pthread_mutex_t lock;
+    results_t res;
+    long pending;
+    jobfile_t *files;
+    long nfiles;
+    long cap;
+    long first;
+} job_t;
+
+/**
+ *  @struct jobtask_t
+ *  @brief argomento di un task job_task, allocato con pathAlloc
+ */
+typedef struct jobtask_t
+{
+    job_t *job;
+    int skip;
+    char path[];
+} jobtask_t;
+
+/**
+ *  @struct server_t
+ *  @brief coda dei job con file da sottomettere, servita a turno dal dispatcher
+ *
+ *  @var readers   thread che stanno leggendo ed esplorando un job, il server li attende prima di terminare
+ *  @var idle      segnalata quando un thread lettore termina
+ *  @var done_head primo job terminato i cui risultati vanno inviati dal writer
+ *  @var done_tail ultimo job terminato
+ *  @var wake      pipe con cui si sveglia il writer
+ *  @var writer    thread writer
+ *  @var closing   il writer termina dopo aver inviato i risultati dei job terminati
+ *  @var started   il writer e' stato avviato
+ */
+typedef struct server_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    job_t *head;
+    job_t *tail;
+    int stop;
+    threadpool_t *tp;
+    int readers;
+    pthread_cond_t idle;
+    job_t *done_head;
+    job_t *done_tail;
+    int wake[2];
+    pthread_t writer;
+    int closing;
+    int started;
+} server_t;
+
+static server_t srv = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+static long next_id = 1;
+
+/**
+ *  @struct reader_t
+ *  @brief argomento di un thread lettore: connessione di un client appena accettata
+ */
+typedef struct reader_t
+{
+    int fd;
+    int nwalker;
+    volatile sig_atomic_t *stop;
+} reader_t;
+
+/**
+ *  @struct output_t
+ *  @brief risultati di un job in corso di invio al client da parte del writer
+ *
+ *  @var fd   connessione del client (non bloccante)
+ *  @var buf  risultati in ordine, nel formato del collector
+ *  @var len  byte di buf
+ *  @var off  byte gia' inviati
+ *  @var last istante dell'ultimo invio riuscito
+ */
+typedef struct output_t
+{
+    int fd;
+    char *buf;
+    size_t len;
+    size_t off;
+    struct timespec last;
+} output_t;
+
+// libera il job, la connessione passa al writer
+static void job_free(job_t *job)
+{
+    resultsFree(&job->res);
+    for (long i = job->first; i < job->nfiles; i++)
+        free(job->files[i].path);
+    free(job->files);
+    pthread_mutex_destroy(&job->lock);
+    free(job);
+}
+
+// n file del job (o la sottomissione) sono terminati, chi li porta a zero passa il job al writer: il worker
+// del pool non attende mai un client
+static void job_release(job_t *job, long n)
+{
+    pthread_mutex_lock(&job->lock);
+    int done = ((job->pending -= n) == 0);
+    pthread_mutex_unlock(&job->lock);
+    if (!done)
+        return;
+    job->next = NULL;
+    pthread_mutex_lock(&srv.lock);
+    if (srv.done_tail == NULL)
+        srv.done_head = job;
+    else
+        srv.done_tail->next = job;
+    srv.done_tail = job;
+    pthread_mutex_unlock(&srv.lock);
+    char c = 0;
+    if (write(srv.wake[1], &c, 1) == -1 && errno != EAGAIN)
+        perror("write");
+}
+
+// task del pool: calcola un file del job e ne memorizza il risultato nel job invece di inviarlo al collector
+static int job_task(jobtask_t *t, taskres_t *res)
+{
+    (void)res;
+    long sum;
+    job_t *job = t->job;
+    int ok = (compute(t->path, &sum) == 0);
+    pthread_mutex_lock(&job->lock);
+    if (ok && resultsStore(&job->res, sum, t->path + t->skip) == -1)
+        perror("resultsStore");
+    pthread_mutex_unlock(&job->lock);
+    job_release(job, 1);
+    return TASK_PARTIAL;
+}
+
+// thread dispatcher: sottomette al pool al piu' SERVER_SLICE file del primo job in coda e lo rimette in fondo
+static void *dispatcher(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&srv.lock);
+        while (srv.head == NULL && !srv.stop)
+            pthread_cond_wait(&srv.cond, &srv.lock);
+        job_t *job = srv.head;
+        if (job == NULL)
+        {
+            pthread_mutex_unlock(&srv.lock);
+            break;
+        }
+        if ((srv.head = job->next) == NULL)
+            srv.tail = NULL;
+        int stop = srv.stop;
+        pthread_mutex_unlock(&srv.lock);
+
+        void *args[SERVER_SLICE];
+        int k = 0;
+        while (!stop && k < SERVER_SLICE && job->first < job->nfiles)
+        {
+            jobfile_t *f = &job->files[job->first++];
+            size_t len = strlen(f->path) + 1;
+            jobtask_t *t = pathAlloc(sizeof(jobtask_t) + len);
+            if (t != NULL)
+            {
+                t->job = job;
+                t->skip = f->skip;
+                memcpy(t->path, f->path, len);
+                args[k++] = t;
+            }
+            else
+                perror("pathAlloc");
+            free(f->path);
+        }
+
+        int added = 0;
+        if (k > 0)
+        {
+            pthread_mutex_lock(&job->lock);
+            job->pending += k;
+            pthread_mutex_unlock(&job->lock);
+            if ((added = addManyTasksToThreadPool(srv.tp, (int (*)(void *, void *))job_task, args, k)) == -1)
+                perror("addManyTasksToThreadPool");
+            added = added > 0 ? added : 0;
+            for (int i = added; i < k; i++)
+                pathFree(args[i]);
+            if (added < k)
+                job_release(job, k - added);
+        }
+
+        if (!stop && added == k && job->first < job->nfiles)
+        { // restano file da sottomettere: il job torna in fondo alla coda
+            pthread_mutex_lock(&srv.lock);
+            job->next = NULL;
+            if (srv.tail == NULL)
+                srv.head = job;
+            else
+                srv.tail->next = job;
+            srv.tail = job;
+            pthread_mutex_unlock(&srv.lock);
+        }
+        else
+            job_release(job, 1); // sottomissione terminata (i file rimasti vengono scartati)
+    }
+    return NULL;
+}
+
+// millisecondi trascorsi da t
+static long elapsed_ms(const struct timespec *t)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - t->tv_sec) * 1000 + (now.tv_nsec - t->tv_nsec) / 1000000;
+}
+
+// prepara l'invio dei risultati di un job terminato e libera il job
+static int output_add(output_t **outs, int *nout, int *cap, job_t *job)
+{
+    output_t o = {job->fd, NULL, 0, 0, {0, 0}};
+    FILE *mem = open_memstream(&o.buf, &o.len);
+    if (mem != NULL)
+    {
+        resultsWrite(&job->res, mem);
+        fclose(mem);
+    }
+    job_free(job);
+    if (mem == NULL || o.len == 0 || fcntl(o.fd, F_SETFL, fcntl(o.fd, F_GETFL) | O_NONBLOCK) == -1)
+    { // niente da inviare
+        free(o.buf);
+        close(o.fd);
+        return 0;
+    }
+    if (*nout == *cap)
+    {
+        int c = *cap ? *cap * 2 : 16;
+        output_t *p = realloc(*outs, c * sizeof(output_t));
+        if (p == NULL)
+        {
+            free(o.buf);
+            close(o.fd);
+            return -1;
+        }
+        *outs = p;
+        *cap = c;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &o.last);
+    (*outs)[(*nout)++] = o;
+    return 0;
+}
+
+/**
+ * funzione writer
+ * @brief thread writer: invia ai client, con scritture non bloccanti guidate da poll, i risultati dei job
+ *        terminati. Un client che non riceve niente per SERVER_REQUEST_MS ms viene scartato, per cui un client
+ *        lento non ritarda gli altri ne' occupa i worker del pool
+ */
+static void *writer(void *arg)
+{
+    (void)arg;
+    output_t *outs = NULL;
+    int nout = 0, cap = 0;
+    struct pollfd *pfds = NULL;
+    int pcap = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&srv.lock);
+        job_t *done = srv.done_head;
+        srv.done_head = srv.done_tail = NULL;
+        int closing = srv.closing;
+        pthread_mutex_unlock(&srv.lock);
+        while (done != NULL)
+        {
+            job_t *next = done->next;
+            if (output_add(&outs, &nout, &cap, done) == -1)
+                perror("output_add");
+            done = next;
+        }
+        if (closing && nout == 0)
+            break; // job_release non viene piu' chiamata: il pool e' stato distrutto
+
+        if (nout + 1 > pcap)
+        {
+            struct pollfd *p = realloc(pfds, (nout + 1) * sizeof(struct pollfd));
+            if (p == NULL)
+            {
+                perror("realloc");
+                continue;
+            }
+            pfds = p;
+            pcap = nout + 1;
+        }
+        pfds[0].fd = srv.wake[0];
+        pfds[0].events = POLLIN;
+        for (int i = 0; i < nout; i++)
+        {
+            pfds[i + 1].fd = outs[i].fd;
+            pfds[i + 1].events = POLLOUT;
+        }
+        if (poll(pfds, nout + 1, SERVER_POLL_MS) == -1 && errno != EINTR)
+            perror("poll");
+        char drain[64];
+        if (pfds[0].revents & POLLIN)
+            while (read(srv.wake[0], drain, sizeof(drain)) > 0)
+                ;
+
+        for (int i = 0; i < nout;)
+        {
+            output_t *o = &outs[i];
+            int finished = 0;
+            if (pfds[i + 1].revents & (POLLOUT | POLLERR | POLLHUP))
+            {
+                ssize_t w = send(o->fd, o->buf + o->off, o->len - o->off, MSG_NOSIGNAL);
+                if (w > 0)
+                {
+                    o->off += w;
+                    clock_gettime(CLOCK_MONOTONIC, &o->last);
+                }
+                finished = (o->off == o->len) || (w == -1 && errno != EAGAIN && errno != EINTR);
+            }
+            if (!finished && elapsed_ms(&o->last) >= SERVER_REQUEST_MS)
+            {
+                fprintf(stderr, "server: client fermo, risultati scartati\n");
+                finished = 1;
+            }
+            if (finished)
+            { // l'ultimo elemento prende il posto di quello concluso, il suo evento e' gia' stato gestito o lo sara'
+                close(o->fd);
+                free(o->buf);
+                outs[i] = outs[nout - 1];
+                pfds[i + 1] = pfds[nout];
+                nout--;
+            }
+            else
+                i++;
+        }
+    }
+    free(outs);
+    free(pfds);
+    return NULL;
+}
+
+// aggiunge un file al job (anche in parallelo dai thread di esplorazione)
+static int job_add(job_t *job, const char *path, int skip)
+{
+    char *copy = strdup(path);
+    if (copy == NULL)
+        return -1;
+    pthread_mutex_lock(&job->lock);
+    if (job->nfiles == job->cap)
+    {
+        long cap = job->cap ? job->cap * 2 : 64;
+        jobfile_t *files = realloc(job->files, cap * sizeof(jobfile_t));
+        if (files == NULL)
+        {
+            pthread_mutex_unlock(&job->lock);
+            free(copy);
+            return -1;
+        }
+        job->files = files;
+        job->cap = cap;
+    }
+    job->files[job->nfiles].path = copy;
+    job->files[job->nfiles].skip = skip;
+    job->nfiles++;
+    pthread_mutex_unlock(&job->lock);
+    return 0;
+}
+
+// job e prefisso da saltare passati alla callback dell'esplorazione
+typedef struct jobwalk_t
+{
+    job_t *job;
+    int skip;
+} jobwalk_t;
+
+static int walk_job_file(const char *path, const struct stat *st, void *arg)
+{
+    (void)st;
+    jobwalk_t *w = (jobwalk_t *)arg;
+    if (job_add(w->job, path, w->skip) == -1)
+        perror("job_add");
+    return 0;
+}
+
+/**
+ * funzione read_request
+ * @brief legge dalla connessione fd il job del client fino alla riga vuota finale (o alla chiusura della
+ *        connessione), attendendo al piu' SERVER_REQUEST_MS ms e controllando stop ogni SERVER_POLL_MS ms
+ * @return il testo del job terminato da '\0', NULL in caso di errore, timeout o terminazione ed errno settato
+ */
+static char *read_request(int fd, volatile sig_atomic_t *stop)
+{
+    size_t cap = 4096, len = 0;
+    char *buf = malloc(cap);
+    if (buf == NULL)
+        return NULL;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // il client non invia niente dopo la riga vuota, per cui basta controllare la fine di quanto ricevuto
+    while (len < 2 || buf[len - 1] != '\n' || buf[len - 2] != '\n')
+    {
+        long left = SERVER_REQUEST_MS - elapsed_ms(&start);
+        if (left <= 0 || *stop)
+        {
+            free(buf);
+            errno = *stop ? ECANCELED : ETIMEDOUT;
+            return NULL;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int r = poll(&pfd, 1, left < SERVER_POLL_MS ? (int)left : SERVER_POLL_MS);
+        if (r == 0 || (r == -1 && errno == EINTR))
+            continue;
+        if (r == -1)
+        {
+            free(buf);
+            return NULL;
+        }
+        if (cap - len < 2)
+        {
+            char *b = realloc(buf, cap * 2);
+            if (b == NULL)
+            {
+                free(buf);
+                return NULL;
+            }
+            buf = b;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len - 1);
+        if (n == 0)
+            break; // connessione chiusa in scrittura dal client: il job e' quello ricevuto finora
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            free(buf);
+            return NULL;
+        }
+        len += n;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+/**
+ * funzione read_job
+ * @brief legge il job inviato dal client sulla connessione fd e ne raccoglie i file, esplorando le directory
+ * @return il job, NULL in caso di errore
+ */
+static job_t *read_job(int fd, int nwalker, volatile sig_atomic_t *stop)
+{
+    char *req = read_request(fd, stop);
+    if (req == NULL)
+        return NULL;
+    job_t *job = calloc(1, sizeof(job_t));
+    if (job == NULL || resultsInit(&job->res, 0) == -1)
+    {
+        free(job);
+        free(req);
+        return NULL;
+    }
+    pthread_mutex_init(&job->lock, NULL);
+    job->fd = fd;
+    job->pending = 1;
+
+    char *cwd = NULL;
+    char full[PATH_MAX];
+    for (char *line = req, *end; *line != '\0' && !*stop; line = end + 1)
+    {
+        if ((end = strchr(line, '\n')) == NULL)
+            end = line + strlen(line) - 1; // ultima riga senza '\n'
+        else
+            *end = '\0';
+        if (cwd == NULL)
+        { // la prima riga e' la directory di lavoro del client
+            cwd = line;
+            continue;
+        }
+        if (*line == '\0')
+            break; // fine del job
+
+        int skip = 0;
+        const char *path = line;
+        if (line[0] != '/')
+        { // i pathname relativi si riferiscono alla directory del client
+            if (snprintf(full, sizeof(full), "%s/%s", cwd, line) >= (int)sizeof(full))
+                continue;
+            path = full;
+            skip = strlen(cwd) + 1;
+        }
+        struct stat st;
+        if (stat(path, &st) == -1)
+        {
+            perror("stat");
+            continue;
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            jobwalk_t w = {job, skip};
+            walker_ops_t ops = {walk_job_file, NULL, &w, 0, stop};
+            if (walkTree(path, nwalker, &ops) == -1)
+                perror("walkTree");
+        }
+        else if (S_ISREG(st.st_mode) && job_add(job, path, skip) == -1)
+            perror("job_add");
+    }
+    free(req);
+    return job;
+}
+
+/**
+ * funzione reader
+ * @brief thread lettore di una connessione: legge ed esplora il job del client e lo mette in coda al dispatcher.
+ *        Ogni connessione ha il proprio lettore, per cui un client lento non ritarda gli altri ne' il controllo
+ *        del flag di terminazione nel ciclo di accept
+ */
+static void *reader(void *arg)
+{
+    reader_t *r = (reader_t *)arg;
+    int fd = r->fd;
+    job_t *job = read_job(fd, r->nwalker, r->stop);
+    if (job == NULL)
+    {
+        perror("read_job");
+        close(fd);
+    }
+    else
+    {
+        pthread_mutex_lock(&srv.lock);
+        job->id = next_id++;
+        pthread_mutex_unlock(&srv.lock);
+        dprintf(fd, "JOB %ld\n", job->id);
+
+        if (job->nfiles == 0)
+            job_release(job, 1);
+        else
+        {
+            pthread_mutex_lock(&srv.lock);
+            if (srv.tail == NULL)
+                srv.head = job;
+            else
+                srv.tail->next = job;
+            srv.tail = job;
+            pthread_cond_signal(&srv.cond);
+            pthread_mutex_unlock(&srv.lock);
+        }
+    }
+    free(r);
+
+    pthread_mutex_lock(&srv.lock);
+    srv.readers--;
+    pthread_cond_signal(&srv.idle);
+    pthread_mutex_unlock(&srv.lock);
+    return NULL;
+}
+
+int serverRun(threadpool_t *tp, const char *sockname, int nwalker, volatile sig_atomic_t *stop)
+{
+    int listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenfd == -1)
+        return -1;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockname, UNIX_PATH_MAX - 1);
+    unlink(sockname);
+    if (bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(listenfd, SOMAXCONN) == -1)
+    {
+        int errtemp = errno;
+        close(listenfd);
+        errno = errtemp;
+        return -1;
+    }
+
+    srv.tp = tp;
+    srv.stop = 0;
+    srv.head = srv.tail = NULL;
+    srv.readers = 0;
+    pthread_cond_init(&srv.idle, NULL);
+    srv.done_head = srv.done_tail = NULL;
+    srv.closing = 0;
+    pthread_t tid;
+    int r = 0;
+    if (pipe(srv.wake) == -1 || fcntl(srv.wake[0], F_SETFL, O_NONBLOCK) == -1 ||
+        fcntl(srv.wake[1], F_SETFL, O_NONBLOCK) == -1 || (r = pthread_create(&srv.writer, NULL, writer, NULL)) != 0)
+    {
+        int errtemp = r ? r : errno;
+        close(listenfd);
+        unlink(sockname);
+        errno = errtemp;
+        return -1;
+    }
+    srv.started = 1;
+    if ((r = pthread_create(&tid, NULL, dispatcher, NULL)) != 0)
+    {
+        close(listenfd);
+        unlink(sockname);
+        errno = r;
+        return -1;
+    }
+
+    struct pollfd pfd = {listenfd, POLLIN, 0};
+    while (!*stop)
+    {
+        // il timeout permette di controllare il flag di terminazione settato dal signal handler
+        if (poll(&pfd, 1, SERVER_POLL_MS) <= 0)
+            continue;
+        int fd = accept(listenfd, NULL, NULL);
+        if (fd == -1)
+            continue;
+        // la risposta al client non puo' bloccare il server oltre SERVER_REQUEST_MS
+        struct timeval tv = {SERVER_REQUEST_MS / 1000, (SERVER_REQUEST_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        reader_t *rd = malloc(sizeof(reader_t));
+        pthread_t rtid;
+        if (rd == NULL)
+        {
+            perror("malloc");
+            close(fd);
+            continue;
+        }
+        rd->fd = fd;
+        rd->nwalker = nwalker;
+        rd->stop = stop;
+        pthread_mutex_lock(&srv.lock);
+        srv.readers++;
+        pthread_mutex_unlock(&srv.lock);
+        if ((r = pthread_create(&rtid, NULL, reader, rd)) != 0)
+        {
+            errno = r;
+            perror("pthread_create");
+            free(rd);
+            close(fd);
+            pthread_mutex_lock(&srv.lock);
+            srv.readers--;
+            pthread_mutex_unlock(&srv.lock);
+            continue;
+        }
+        pthread_detach(rtid);
+    }
+
+    // i lettori si accorgono di stop entro SERVER_POLL_MS e mettono in coda i job gia' letti
+    pthread_mutex_lock(&srv.lock);
+    while (srv.readers > 0)
+        pthread_cond_wait(&srv.idle, &srv.lock);
+    pthread_mutex_unlock(&srv.lock);
+    pthread_cond_destroy(&srv.idle);
+
+    close(listenfd);
+    unlink(sockname);
+    // il dispatcher chiude i job ancora in coda senza sottomettere i file rimasti
+    pthread_mutex_lock(&srv.lock);
+    srv.stop = 1;
+    pthread_cond_signal(&srv.cond);
+    pthread_mutex_unlock(&srv.lock);
+    pthread_join(tid, NULL);
+    return 0;
+}
+
+void serverClose(void)
+{
+    if (!srv.started)
+        return;
+    pthread_mutex_lock(&srv.lock);
+    srv.closing = 1;
+    pthread_mutex_unlock(&srv.lock);
+    char c = 0;
+    if (write(srv.wake[1], &c, 1) == -1 && errno != EAGAIN)
+        perror("write");
+    pthread_join(srv.writer, NULL);
+    close(srv.wake[0]);
+    close(srv.wake[1]);
+    srv.started = 0;
+}
+
+int serverSubmit(const char *sockname, char *paths[], int n)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockname, UNIX_PATH_MAX - 1);
+    char cwd[PATH_MAX];
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || getcwd(cwd, sizeof(cwd)) == NULL)
+    {
+        int errtemp = errno;
+        close(fd);
+        errno = errtemp;
+        return -1;
+    }
+
+    // directory di lavoro, un pathname per riga e una riga vuota
+    dprintf(fd, "%s\n", cwd);
+    for (int i = 0; i < n; i++)
+        dprintf(fd, "%s\n", paths[i]);
+    dprintf(fd, "\n");
+
+    char buf[4096];
+    ssize_t r;
+    while ((r = read(fd, buf, sizeof(buf))) != 0)
+    {
+        if (r == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            return -1;
+        }
+        fwrite(buf, 1, r, stdout);
+    }
+    fflush(stdout);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,219 @@
+/***********************************/
+//  implementation file shmring.c   /
+/*=================================*/
+
+#define _GNU_SOURCE // memfd_create
+
+// include
+#include <util.h>
+#include <shmring.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+// dimensione del record con un pathname di length byte
+#define REC_SIZE(length) (2 * sizeof(long) + (((size_t)(length) + RING_ALIGN - 1) & ~(size_t)(RING_ALIGN - 1)))
+
+// i dati iniziano dopo l'intestazione, allineati a una linea di cache
+#define DATA_OFFSET ((sizeof(ringhdr_t) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1))
+
+// incrementa il contatore dell'eventfd fd per svegliare l'altro lato
+static void ring_signal(int fd)
+{
+    uint64_t one = 1;
+    while (write(fd, &one, sizeof(one)) == -1 && errno == EINTR)
+        ;
+}
+
+int ringCreate(shmring_t *r)
+{
+    r->hdr = NULL;
+    r->memfd = r->datafd = r->spacefd = -1;
+    r->mapsize = DATA_OFFSET + RING_SIZE;
+
+    if ((r->memfd = memfd_create("farm-ring", MFD_CLOEXEC)) == -1 || ftruncate(r->memfd, r->mapsize) == -1 ||
+        (r->datafd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1 ||
+        (r->spacefd = eventfd(0, EFD_CLOEXEC)) == -1)
+    {
+        ringDestroy(r);
+        return -1;
+    }
+    void *p = mmap(NULL, r->mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, r->memfd, 0);
+    if (p == MAP_FAILED)
+    {
+        ringDestroy(r);
+        return -1;
+    }
+    r->hdr = (ringhdr_t *)p; // la regione appena creata e' azzerata: head, tail e waiting partono da 0
+    r->hdr->size = r->size = RING_SIZE;
+    r->notified = 0;
+    r->data = (char *)p + DATA_OFFSET;
+    return 0;
+}
+
+int ringAttach(shmring_t *r, int memfd, int datafd, int spacefd)
+{
+    r->hdr = NULL;
+    r->memfd = memfd;
+    r->datafd = datafd;
+    r->spacefd = spacefd;
+
+    struct stat st;
+    if (fstat(memfd, &st) == -1)
+    {
+        ringDestroy(r);
+        return -1;
+    }
+    r->mapsize = st.st_size;
+    void *p = (r->mapsize > DATA_OFFSET) ? mmap(NULL, r->mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0) : MAP_FAILED;
+    if (p == MAP_FAILED)
+    {
+        ringDestroy(r);
+        errno = EINVAL;
+        return -1;
+    }
+    r->hdr = (ringhdr_t *)p;
+    r->data = (char *)p + DATA_OFFSET;
+    // la dimensione viene dall'altro processo: la accetto solo se e' coerente con la regione
+    size_t size = r->hdr->size;
+    if (size < 2 * REC_SIZE(PATH_MAX) || (size & (size - 1)) != 0 || size > r->mapsize - DATA_OFFSET)
+    {
+        ringDestroy(r);
+        errno = EINVAL;
+        return -1;
+    }
+    r->size = size;
+    r->notified = 0;
+    return 0;
+}
+
+int ringPut(shmring_t *r, long result, const char *name)
+{
+    ringhdr_t *hdr = r->hdr;
+    size_t size = r->size;
+    long length = strlen(name) + 1;
+    size_t rec = REC_SIZE(length);
+    if (length > PATH_MAX)
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    size_t tail = hdr->tail; // solo questo thread scrive tail
+    size_t off = tail & (size - 1);
+    size_t pad = (size - off < rec) ? size - off : 0; // il record non si spezza: riempio fino alla fine
+
+    // attendo che il collector liberi abbastanza spazio
+    for (;;)
+    {
+        size_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+        if (size - (tail - head) >= pad + rec)
+            break;
+        ringNotify(r); // il collector deve consumare per liberare spazio
+        __atomic_store_n(&hdr->waiting, 1, __ATOMIC_SEQ_CST);
+        head = __atomic_load_n(&hdr->head, __ATOMIC_SEQ_CST);
+        if (size - (tail - head) >= pad + rec)
+        {
+            __atomic_store_n(&hdr->waiting, 0, __ATOMIC_RELAXED);
+            break;
+        }
+        uint64_t v;
+        if (read(r->spacefd, &v, sizeof(v)) == -1 && errno != EINTR)
+            return -1;
+    }
+
+    size_t pos = tail;
+    if (pad > 0)
+    {
+        long fill = -1;
+        memcpy(r->data + off + sizeof(long), &fill, sizeof(long));
+        pos += pad;
+        off = 0;
+    }
+    memcpy(r->data + off, &result, sizeof(long));
+    memcpy(r->data + off + sizeof(long), &length, sizeof(long));
+    memcpy(r->data + off + 2 * sizeof(long), name, length);
+
+    // pubblico il record, la segnalazione avviene a lotti con ringNotify
+    __atomic_store_n(&hdr->tail, pos + rec, __ATOMIC_RELEASE);
+    return 0;
+}
+
+size_t ringUnnotified(const shmring_t *r)
+{
+    return r->hdr->tail - r->notified;
+}
+
+void ringNotify(shmring_t *r)
+{
+    if (r->hdr->tail != r->notified)
+    {
+        r->notified = r->hdr->tail;
+        ring_signal(r->datafd);
+    }
+}
+
+long ringDrain(shmring_t *r, int (*fun)(long result, char *name, void *arg), void *arg)
+{
+    ringhdr_t *hdr = r->hdr;
+    size_t size = r->size;
+    long n = 0;
+
+    // azzero il contatore prima di leggere tail: una segnalazione successiva resta pendente
+    uint64_t v;
+    if (read(r->datafd, &v, sizeof(v)) == -1 && errno != EAGAIN && errno != EINTR)
+        return -1;
+
+    size_t head = hdr->head; // solo il collector scrive head
+    for (;;)
+    {
+        size_t tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+        if (tail == head || tail - head > size)
+            return (tail == head) ? n : -1;
+
+        while (head != tail)
+        {
+            size_t off = head & (size - 1);
+            long result, length;
+            memcpy(&result, r->data + off, sizeof(long));
+            memcpy(&length, r->data + off + sizeof(long), sizeof(long));
+            if (length == -1)
+            { // riempimento fino alla fine dell'anello
+                if (size - off > tail - head)
+                    return -1;
+                head += size - off;
+                continue;
+            }
+            if (length <= 0 || length > PATH_MAX || REC_SIZE(length) > size - off || REC_SIZE(length) > tail - head)
+                return -1;
+            char *name = r->data + off + 2 * sizeof(long);
+            name[length - 1] = '\0';
+            if (fun(result, name, arg) == -1)
+                return -1;
+            n++;
+            head += REC_SIZE(length);
+        }
+
+        // restituisco lo spazio e sveglio il worker se aspetta; poi ricontrollo tail
+        __atomic_store_n(&hdr->head, head, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&hdr->waiting, __ATOMIC_SEQ_CST))
+        {
+            __atomic_store_n(&hdr->waiting, 0, __ATOMIC_RELAXED);
+            ring_signal(r->spacefd);
+        }
+    }
+}
+
+void ringDestroy(shmring_t *r)
+{
+    if (r->hdr != NULL)
+        munmap(r->hdr, r->mapsize);
+    r->hdr = NULL;
+    if (r->memfd != -1)
+        close(r->memfd);
+    if (r->datafd != -1)
+        close(r->datafd);
+    if (r->spacefd != -1)
+        close(r->spacefd);
+    r->memfd = r->datafd = r->spacefd = -1;
+}
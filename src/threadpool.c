@@ -12,7 +12,446 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sched.h>
 #include <threadpool.h>
+#include <lfqueue.h>
+#include <wsdeque.h>
+#include <pathalloc.h>
+#include <sender.h>
+
+// limiti dello spin adattivo dei worker (backend lock-free) prima di sospendersi sulla variabile di condizione
+#define SPIN_MIN 16
+#define SPIN_MAX 4096
+
+// suggerisce alla CPU che il thread sta facendo busy waiting
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// invio dei risultati del thread worker corrente (NULL se il thread non e' un worker)
+static __thread sender_t *self_sender = NULL;
+
+// invia i risultati accumulati dal worker corrente prima che si sospenda in attesa di lavoro
+// @return 1 se c'erano risultati da inviare, 0 altrimenti
+static int flush_idle(void)
+{
+    if (self_sender == NULL || !senderPending(self_sender))
+        return 0;
+    senderFlush(self_sender);
+    return 1;
+}
+
+/*******************************************/
+// backend POOL_QUEUE_MUTEX
+/*=========================================*/
+
+/**
+ * @function mutex_take
+ * @brief estrae un task dalla coda protetta da pool->lock, sospendendosi finche' la coda e' vuota
+ * @return 0 se e' stato estratto un task, -1 se il thread deve uscire
+ */
+static int mutex_take(threadpool_t *pool, taskfun_t *task)
+{
+    // acquisisco la lock
+    LOCK_RETURN(&(pool->lock), -1);
+
+    // in attesa di un messaggio, controllo spurious wakeups.
+    while ((pool->count == 0) && (!pool->exiting))
+    { // finchè non ci sono task e non devo uscire
+        if (self_sender != NULL && senderPending(self_sender))
+        { // prima di sospendermi invio i risultati accumulati, senza tenere la lock
+            UNLOCK_RETURN(&(pool->lock), -1);
+            flush_idle();
+            LOCK_RETURN(&(pool->lock), -1);
+            continue;
+        }
+        pthread_cond_wait(&(pool->cond_consumer), &(pool->lock)); // mi metto in attesa sulla variabile di condizione (not-empty)
+    }
+
+    if (pool->exiting > 1)
+    {
+        UNLOCK_RETURN(&(pool->lock), -1);
+        return -1; // exit forzato, esco immediatamente
+    }
+
+    if (pool->exiting == 1 && !pool->count)
+    {
+        UNLOCK_RETURN(&(pool->lock), -1);
+        return -1; // devo uscire E NON ci sono messaggi pendenti ALLORA ESCO
+    }
+    // nuovo task
+    task->fun = pool->pending_queue[pool->head].fun; // prendo la funzione da eseguire dal task in testa alla coda
+    task->arg = pool->pending_queue[pool->head].arg; // prendo l'argomento dal task in testa alla coda
+
+    pool->head++;
+    pool->count--;                                                       // sposto il puntatore alla testa, diminuisco il contatore dei task pendenti
+    pool->head = (pool->head == abs(pool->queue_size)) ? 0 : pool->head; // la coda è implementata circolarmente
+
+    pool->taskonthefly++; // incremento il contatore dei task serviti al momento
+
+    int r;
+    if ((r = pthread_cond_signal(&(pool->cond_producer))) != 0)
+    { // faccio una signal per svegliare un producer in attesa xk ho liberato un posto nella coda
+        UNLOCK_RETURN(&(pool->lock), -1);
+        errno = r;
+        return -1;
+    }
+
+    UNLOCK_RETURN(&(pool->lock), -1); // rilascio la lock xk non ho più bisogno della mutua esclusione
+    return 0;
+}
+
+/**
+ * @function mutex_add
+ * @brief inserisce un task nella coda protetta da pool->lock, sospendendosi finche' la coda e' piena
+ * @return come addTaskToThreadPool
+ */
+static int mutex_add(threadpool_t *pool, int (*f)(void *, void *), void *arg)
+{
+    LOCK_RETURN(&(pool->lock), -1);
+    int queue_size = abs(pool->queue_size);
+    int nopending = (pool->queue_size == -1); // non dobbiamo gestire messaggi pendenti
+
+    // finchè la coda è piena e non devo uscire mi sospendo
+    while (pool->count >= queue_size && (!pool->exiting))
+    {
+        pthread_cond_wait(&(pool->cond_producer), &(pool->lock));
+    }
+
+    // in fase di uscita
+    if (pool->exiting)
+    {
+        UNLOCK_RETURN(&(pool->lock), -1);
+        return 1; // esco con valore "coda piena" (non ho aggiunto)
+    }
+
+    if (pool->taskonthefly >= pool->numthreads) // tutti i thread sono occupati
+    {
+        if (nopending)
+        {
+            // tutti i thread sono occupati e non si gestiscono task pendenti
+            assert(pool->count == 0);
+
+            UNLOCK_RETURN(&(pool->lock), -1);
+            return 1; // esco con valore "coda piena"
+        }
+    }
+    // inserisco in coda
+    pool->pending_queue[pool->tail].fun = (int (*)(void *, void *))f;
+    pool->pending_queue[pool->tail].arg = arg;
+    pool->count++; // incremento il numero dei task pendenti
+    pool->tail++;  // incremento il puntatore alla coda
+    if (pool->tail >= queue_size)
+        pool->tail = 0;
+
+    int r;
+    if ((r = pthread_cond_signal(&(pool->cond_consumer))) != 0)
+    { // faccio una signal per svegliare un worker in attesa
+        UNLOCK_RETURN(&(pool->lock), -1);
+        errno = r;
+        return -1;
+    }
+
+    UNLOCK_RETURN(&(pool->lock), -1);
+    return 0;
+}
+
+/**
+ * @function mutex_add_many
+ * @brief inserisce i task args[0..n-1] nella coda con una sola acquisizione di pool->lock e un solo broadcast finale.
+ *        Se la coda si riempie a meta' del lotto sveglia i worker e si sospende finche' non si libera un posto.
+ * @return come addManyTasksToThreadPool
+ */
+static int mutex_add_many(threadpool_t *pool, int (*f)(void *, void *), void *args[], int n)
+{
+    LOCK_RETURN(&(pool->lock), -1);
+    int queue_size = abs(pool->queue_size);
+    int nopending = (pool->queue_size == -1);
+    int added = 0;
+
+    while (added < n)
+    {
+        while (pool->count >= queue_size && (!pool->exiting))
+        {
+            // i task gia' inseriti non sono ancora stati segnalati: sveglio i worker prima di sospendermi
+            pthread_cond_broadcast(&(pool->cond_consumer));
+            pthread_cond_wait(&(pool->cond_producer), &(pool->lock));
+        }
+        if (pool->exiting)
+            break;
+        if (nopending && pool->taskonthefly + pool->count >= pool->numthreads)
+            break; // tutti i thread sono occupati e non si gestiscono task pendenti
+
+        pool->pending_queue[pool->tail].fun = (int (*)(void *, void *))f;
+        pool->pending_queue[pool->tail].arg = args[added++];
+        pool->count++;
+        pool->tail++;
+        if (pool->tail >= queue_size)
+            pool->tail = 0;
+    }
+
+    int r;
+    if (added > 0 && (r = pthread_cond_broadcast(&(pool->cond_consumer))) != 0)
+    {
+        UNLOCK_RETURN(&(pool->lock), -1);
+        errno = r;
+        return -1;
+    }
+
+    UNLOCK_RETURN(&(pool->lock), -1);
+    return added;
+}
+
+// pool e indice del thread worker corrente (-1 se il thread non e' un worker), usati dal backend
+// POOL_QUEUE_STEALING per inserire i sottotask creati da un worker nella sua deque
+static __thread threadpool_t *self_pool = NULL;
+static __thread int self_id = -1;
+
+/*******************************************/
+// backend POOL_QUEUE_LOCKFREE e POOL_QUEUE_STEALING
+/*=========================================*/
+
+/*
+ * Produttori e worker accedono alla coda (o alle deque) senza il lock del pool. pool->lock e le variabili di condizione servono solo a
+ * sospendere chi ha trovato la coda piena (produttori) o vuota (worker) dopo uno spin: chi si sospende
+ * incrementa il contatore dei sospesi e poi ricontrolla la coda, chi inserisce/estrae controlla il
+ * contatore dopo l'operazione (entrambi con ordinamento seq_cst), per cui almeno uno dei due vede l'altro
+ * e non si perdono risvegli. pool->inflight conta i produttori che hanno superato il controllo di
+ * pool->exiting ma non hanno ancora inserito: i worker escono (exiting == 1) solo quando e' 0 e la coda e' vuota.
+ */
+
+// sveglia un thread sospeso su cond se il contatore dei sospesi e' positivo
+static void wake_one(threadpool_t *pool, int *sleeping, pthread_cond_t *cond)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(sleeping, __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_mutex_lock(&(pool->lock));
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&(pool->lock));
+    }
+}
+
+// contabilizza il task appena estratto e sveglia un eventuale produttore in attesa di spazio
+static int took(threadpool_t *pool)
+{
+    __atomic_add_fetch(&pool->taskonthefly, 1, __ATOMIC_RELAXED);
+    wake_one(pool, &pool->sleeping_producers, &pool->cond_producer);
+    return 0;
+}
+
+// tentativo di estrazione dalla coda lock-free
+static int lf_try(threadpool_t *pool, int myid, taskfun_t *task)
+{
+    (void)myid;
+    return lfqPop(pool->lfq, task);
+}
+
+// tentativo di estrazione con work stealing: prima dalla propria deque, poi dalle deque degli altri worker
+static int ws_try(threadpool_t *pool, int myid, taskfun_t *task)
+{
+    int n = pool->numthreads;
+    int got = (wsdPop(&pool->deques[myid], task) == 0);
+    for (int k = 1; !got && k < n; k++)
+        got = (wsdSteal(&pool->deques[(myid + k) % n], task) == 0);
+    if (!got)
+        return -1;
+    __atomic_sub_fetch(&pool->count, 1, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+/**
+ * @function spin_take
+ * @brief estrae un task con la funzione try: prima fa uno spin di al piu' *spin tentativi, poi si sospende.
+ *        Il limite dello spin si adatta: raddoppia se lo spin ha trovato lavoro, si dimezza se e' andato a vuoto.
+ * @return 0 se e' stato estratto un task, -1 se il thread deve uscire
+ */
+static int spin_take(threadpool_t *pool, int myid, taskfun_t *task, int *spin,
+                     int (*try)(threadpool_t *, int, taskfun_t *))
+{
+    for (;;)
+    {
+        for (int i = 0; i < *spin; i++)
+        {
+            if (try(pool, myid, task) == 0)
+            {
+                if (i > 0 && *spin < SPIN_MAX)
+                    *spin *= 2;
+                return took(pool);
+            }
+            int exiting = __atomic_load_n(&pool->exiting, __ATOMIC_SEQ_CST);
+            if (exiting > 1)
+                return -1; // exit forzato, esco immediatamente
+            if (exiting == 1 && __atomic_load_n(&pool->inflight, __ATOMIC_SEQ_CST) == 0)
+            { // nessun produttore puo' piu' inserire: esco se la coda e' vuota
+                if (try(pool, myid, task) == 0)
+                    return took(pool);
+                return -1;
+            }
+            cpu_relax();
+        }
+        if (*spin > SPIN_MIN)
+            *spin /= 2;
+        if (flush_idle())
+            continue; // prima di sospendermi invio i risultati accumulati e riprovo
+
+        // mi sospendo sulla variabile di condizione (not-empty)
+        int got;
+        LOCK_RETURN(&(pool->lock), -1);
+        __atomic_add_fetch(&pool->sleeping_consumers, 1, __ATOMIC_SEQ_CST);
+        got = (try(pool, myid, task) == 0);
+        if (!got && !pool->exiting)
+            pthread_cond_wait(&(pool->cond_consumer), &(pool->lock));
+        __atomic_sub_fetch(&pool->sleeping_consumers, 1, __ATOMIC_SEQ_CST);
+        UNLOCK_RETURN(&(pool->lock), -1);
+        if (got)
+            return took(pool);
+    }
+}
+
+/**
+ * @function lf_add
+ * @brief inserisce un task nella coda lock-free, se la coda e' piena fa uno spin e poi si sospende
+ * @param wake se 0 non sveglia i worker dopo l'inserimento (inserimento a lotti, sveglia il chiamante alla fine)
+ * @return come addTaskToThreadPool
+ */
+static int lf_add(threadpool_t *pool, int (*f)(void *, void *), void *arg, int wake)
+{
+    taskfun_t task;
+    task.fun = f;
+    task.arg = arg;
+
+    __atomic_add_fetch(&pool->inflight, 1, __ATOMIC_SEQ_CST);
+    int ret = 0;
+    int spin = 0;
+    for (;;)
+    {
+        if (__atomic_load_n(&pool->exiting, __ATOMIC_SEQ_CST))
+        {
+            ret = 1; // esco con valore "coda piena" (non ho aggiunto)
+            break;
+        }
+        if (pool->queue_size == -1 && __atomic_load_n(&pool->taskonthefly, __ATOMIC_RELAXED) >= pool->numthreads)
+        {
+            ret = 1; // tutti i thread sono occupati e non si gestiscono task pendenti
+            break;
+        }
+        if (lfqPush(pool->lfq, &task) == 0)
+            break;
+        if (spin++ < SPIN_MAX)
+        {
+            cpu_relax();
+            continue;
+        }
+
+        // coda piena: mi sospendo sulla variabile di condizione (not-full)
+        int done;
+        LOCK_RETURN(&(pool->lock), -1);
+        __atomic_add_fetch(&pool->sleeping_producers, 1, __ATOMIC_SEQ_CST);
+        done = (lfqPush(pool->lfq, &task) == 0);
+        if (!done && !pool->exiting)
+        {
+            pthread_cond_broadcast(&(pool->cond_consumer)); // i worker potrebbero attendere un lotto non ancora segnalato
+            pthread_cond_wait(&(pool->cond_producer), &(pool->lock));
+        }
+        __atomic_sub_fetch(&pool->sleeping_producers, 1, __ATOMIC_SEQ_CST);
+        UNLOCK_RETURN(&(pool->lock), -1);
+        if (done)
+            break;
+    }
+    __atomic_sub_fetch(&pool->inflight, 1, __ATOMIC_SEQ_CST);
+
+    if (ret == 0 && wake)
+        wake_one(pool, &pool->sleeping_consumers, &pool->cond_consumer);
+    return ret;
+}
+
+/**
+ * @function ws_add
+ * @brief inserisce un task in una deque del backend work stealing.
+ *        Un task creato da un worker del pool va nella deque del worker stesso e non attende mai (un worker
+ *        bloccato sulla coda piena potrebbe bloccare tutto il pool), anche durante lo svuotamento (exiting == 1).
+ *        Un task sottomesso da un altro thread va nelle deque a turno (round-robin), rispettando la dimensione
+ *        massima della coda dei task pendenti.
+ * @param wake se 0 non sveglia i worker dopo l'inserimento (inserimento a lotti, sveglia il chiamante alla fine)
+ * @return come addTaskToThreadPool
+ */
+static int ws_add(threadpool_t *pool, int (*f)(void *, void *), void *arg, int wake)
+{
+    taskfun_t task;
+    task.fun = f;
+    task.arg = arg;
+    int local = (self_pool == pool);
+    int queue_size = abs(pool->queue_size);
+
+    __atomic_add_fetch(&pool->inflight, 1, __ATOMIC_SEQ_CST);
+    int ret = 0;
+    int spin = 0;
+    for (;;)
+    {
+        int exiting = __atomic_load_n(&pool->exiting, __ATOMIC_SEQ_CST);
+        if (exiting > 1 || (exiting && !local))
+        {
+            ret = 1; // esco con valore "coda piena" (non ho aggiunto)
+            break;
+        }
+        if (local)
+        {
+            __atomic_add_fetch(&pool->count, 1, __ATOMIC_SEQ_CST);
+            if (wsdPush(&pool->deques[self_id], &task) == -1)
+            {
+                __atomic_sub_fetch(&pool->count, 1, __ATOMIC_SEQ_CST);
+                ret = -1;
+            }
+            break;
+        }
+        if (pool->queue_size == -1 && __atomic_load_n(&pool->taskonthefly, __ATOMIC_RELAXED) >= pool->numthreads)
+        {
+            ret = 1; // tutti i thread sono occupati e non si gestiscono task pendenti
+            break;
+        }
+        // prenoto un posto tra i task pendenti
+        int count = __atomic_load_n(&pool->count, __ATOMIC_SEQ_CST);
+        if (count < queue_size && __atomic_compare_exchange_n(&pool->count, &count, count + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            int victim = (unsigned)__atomic_fetch_add(&pool->next_deque, 1, __ATOMIC_RELAXED) % pool->numthreads;
+            if (wsdPush(&pool->deques[victim], &task) == -1)
+            {
+                __atomic_sub_fetch(&pool->count, 1, __ATOMIC_SEQ_CST);
+                ret = -1;
+            }
+            break;
+        }
+        if (spin++ < SPIN_MAX)
+        {
+            cpu_relax();
+            continue;
+        }
+
+        // coda piena: mi sospendo sulla variabile di condizione (not-full) finche' un worker non estrae un task
+        LOCK_RETURN(&(pool->lock), -1);
+        __atomic_add_fetch(&pool->sleeping_producers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pool->count, __ATOMIC_SEQ_CST) >= queue_size && !pool->exiting)
+        {
+            pthread_cond_broadcast(&(pool->cond_consumer)); // i worker potrebbero attendere un lotto non ancora segnalato
+            pthread_cond_wait(&(pool->cond_producer), &(pool->lock));
+        }
+        __atomic_sub_fetch(&pool->sleeping_producers, 1, __ATOMIC_SEQ_CST);
+        UNLOCK_RETURN(&(pool->lock), -1);
+    }
+    __atomic_sub_fetch(&pool->inflight, 1, __ATOMIC_SEQ_CST);
+
+    if (ret == 0 && wake)
+        wake_one(pool, &pool->sleeping_consumers, &pool->cond_consumer);
+    return ret;
+}
+
+/*******************************************/
+// thread worker
+/*=========================================*/
 
 /**
  * @function void *workerpool_thread(void *threadpool)
@@ -22,6 +461,7 @@ static void *workerpool_thread(void *threadpool)
 {
     threadpool_t *pool = (threadpool_t *)threadpool; // cast
     taskfun_t task;                                  // generic task
+    int spin = SPIN_MIN;                             // limite dello spin adattivo (backend lock-free)
 
     pthread_t self = pthread_self(); // restituisce l' identificatore del thread (lo stesso restituito dalla pthread_create)
     int myid = -1;
@@ -36,88 +476,76 @@ static void *workerpool_thread(void *threadpool)
             }
     } while (myid < 0);
 
+    self_pool = pool;
+    self_id = myid;
+
     // ciascun thread worker del threadpool ha una connessione col processo collector
 
     // stabilisco la connessione
 
-    // creo e connetto il socket
+    // creo e connetto il socket (con il collector interno alla farm non serve)
     struct sockaddr_un serv_addr;
-    int serverfd;
-    SYSCALL_EXIT("socket", serverfd, socket(AF_UNIX, SOCK_STREAM, 0), "socket", "");
-    memset(&serv_addr, '0', sizeof(serv_addr));
+    int serverfd = -1;
+    if (pool->protocol != PROTO_INPROC)
+    {
+        SYSCALL_EXIT("socket", serverfd, socket(AF_UNIX, SOCK_STREAM, 0), "socket", "");
+        memset(&serv_addr, '0', sizeof(serv_addr));
 
-    serv_addr.sun_family = AF_UNIX;
-    strncpy(serv_addr.sun_path, SOCKNAME, UNIX_PATH_MAX);
-    // printf("%s\n",serv_addr.sun_path );
+        serv_addr.sun_family = AF_UNIX;
+        strncpy(serv_addr.sun_path, SOCKNAME, UNIX_PATH_MAX);
+        // printf("%s\n",serv_addr.sun_path );
 
-    while (connect(serverfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == -1)
-    {
-        if (!pool->exiting && errno == ENOENT)
-            msleep(100); /* sock non esiste */
-        else
+        // il master crea il pool solo dopo che il collector e' in ascolto, non serve riprovare
+        if (connect(serverfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == -1)
         {
+            perror("connect");
             close(serverfd);
             return NULL;
         }
     }
 
-    // sono connesso
-
-    // acquisisco la lock
-    LOCK_RETURN(&(pool->lock), NULL);
+    // sono connesso: concordo la versione del protocollo con il collector
+    sender_t sender;
+    if (senderInit(&sender, serverfd, pool->protocol) == -1)
+    {
+        perror("senderInit");
+        free(sender.buf);
+        close(serverfd);
+        return NULL;
+    }
+    self_sender = &sender;
 
     for (;;)
     {
-
-        // in attesa di un messaggio, controllo spurious wakeups.
-        while ((pool->count == 0) && (!pool->exiting))
-        {                                                             // finchè non ci sono task e non devo uscire
-            pthread_cond_wait(&(pool->cond_consumer), &(pool->lock)); // mi metto in attesa sulla variabile di condizione (not-empty)
-        }
-
-        if (pool->exiting > 1)
-        {
-            close(serverfd);
-            break; // exit forzato, esco immediatamente
-        }
-
-        if (pool->exiting == 1 && !pool->count)
+        // prendo il prossimo task, -1 se devo uscire
+        int ret;
+        if (pool->queue_type == POOL_QUEUE_LOCKFREE)
+            ret = spin_take(pool, myid, &task, &spin, lf_try);
+        else if (pool->queue_type == POOL_QUEUE_STEALING)
+            ret = spin_take(pool, myid, &task, &spin, ws_try);
+        else
+            ret = mutex_take(pool, &task);
+        if (ret == -1)
         {
+            senderClose(&sender);
             close(serverfd);
-            break; // devo uscire E NON ci sono messaggi pendenti ALLORA ESCO
-        }
-        // nuovo task
-        task.fun = pool->pending_queue[pool->head].fun; // prendo la funzione da eseguire dal task in testa alla coda
-        task.arg = pool->pending_queue[pool->head].arg; // prendo l'argomento dal task in testa alla coda
-
-        pool->head++;
-        pool->count--;                                                       // sposto il puntatore alla testa, diminuisco il contatore dei task pendenti
-        pool->head = (pool->head == abs(pool->queue_size)) ? 0 : pool->head; // la coda è implementata circolarmente
-
-        pool->taskonthefly++; // incremento il contatore dei task serviti al momento
-
-        int r;
-        if ((r = pthread_cond_signal(&(pool->cond_producer))) != 0)
-        { // faccio una signal per svegliare un producer in attesa xk ho liberato un posto nella coda
-            UNLOCK_RETURN(&(pool->lock), NULL);
-            close(serverfd);
-            errno = r;
-            return NULL;
+            break;
         }
 
-        UNLOCK_RETURN(&(pool->lock), NULL); // rilascio la lock xk non ho più bisogno della mutua esclusione
-
-        // variable to store the result of the computation
-        long sum;
+        // variable to store the result of the computation (name defaults to the task argument)
+        taskres_t res;
+        res.name = task.arg;
         // return value of the function
         int ret_val;
         // eseguo la funzione, passo come argomento il pathname del file su cui lavorare e il puntatore a dove salvare il risultato
-        ret_val = (*(task.fun))(task.arg, &sum);
+        ret_val = (*(task.fun))(task.arg, &res);
 
-        if (ret_val != 0)
+        if (ret_val == -1)
         {
             perror("error with the compute function");
+            senderClose(&sender);
             close(serverfd);
+            pathallocThreadFlush();
             return NULL;
         }
 
@@ -128,40 +556,52 @@ static void *workerpool_thread(void *threadpool)
         /* communication of the result */
         /*******************************/
 
-        // lenght of the message with the filename
-        long message_length = strlen(task.arg) + 1;
-
-        long codice = 0;                         // code 0 --> message with (result, filename) to store
-        writen(serverfd, &codice, sizeof(long)); // send the code
+        if (ret_val == TASK_DONE)
+        {
+            // send (result, filename): immediately with protocol 1, in the next frame with protocol 2
+            senderPut(&sender, res.sum, res.name);
+        }
 
-        writen(serverfd, &sum, sizeof(long)); // send result
-        // printf("%ld\n", sum );
-        // fflush(stdout);
-        writen(serverfd, &message_length, sizeof(long)); // send a long with the lenght of the filename
-        // printf("%ld\n", message_length );
-        // fflush(stdout);
-        // send filename
-        writen(serverfd, task.arg, sizeof(char) * message_length);
-        // printf("%s\n", task.arg );
-        // fflush(stdout);
+        if (res.name != task.arg)
+            pathFree(res.name);
+        pathFree(task.arg);
 
-        free(task.arg);
-        // riacquisisco la lock
-        LOCK_RETURN(&(pool->lock), NULL);
-        pool->taskonthefly--; // diminuisco il contatore dei task serviti correntemente
+        // diminuisco il contatore dei task serviti correntemente
+        if (pool->queue_type != POOL_QUEUE_MUTEX)
+            __atomic_sub_fetch(&pool->taskonthefly, 1, __ATOMIC_RELAXED);
+        else
+        {
+            LOCK_RETURN(&(pool->lock), NULL);
+            pool->taskonthefly--;
+            UNLOCK_RETURN(&(pool->lock), NULL);
+        }
     }
-    UNLOCK_RETURN(&(pool->lock), NULL); // rilascio la lock
 
+    self_sender = NULL;
     // fprintf(stderr, "thread %d exiting\n", myid);
+    pathallocThreadFlush(); // restituisco i blocchi liberi di questo thread al deposito globale
     return NULL;
 }
 
+// libera la coda dei task pendenti, qualunque sia la sua implementazione
+static void freeQueue(threadpool_t *pool)
+{
+    free(pool->pending_queue);
+    lfqDestroy(pool->lfq);
+    if (pool->deques != NULL)
+    {
+        for (int i = 0; i < pool->ndeques; i++)
+            wsdDestroy(&pool->deques[i]);
+        free(pool->deques);
+    }
+}
+
 static int freePoolResources(threadpool_t *pool)
 {
     if (pool->threads)
     {
         free(pool->threads);
-        free(pool->pending_queue);
+        freeQueue(pool);
 
         pthread_mutex_destroy(&(pool->lock));
         pthread_cond_destroy(&(pool->cond_producer));
@@ -173,16 +613,47 @@ static int freePoolResources(threadpool_t *pool)
 
 /**
  * @function createThreadPool
- * @brief Crea un oggetto thread pool.
+ * @brief Crea un oggetto thread pool con la coda dei task pendenti protetta da mutex.
  * @param numthreads è il numero di thread del pool
  * @param pending_size è la size delle richieste che possono essere pendenti. Questo parametro è 0 se si vuole utilizzare un modello per il pool con 1 thread 1 richiesta, cioe' non ci sono richieste pendenti.
  *
  * @return un nuovo thread pool oppure NULL ed errno settato opportunamente
  */
 threadpool_t *createThreadPool(int numthreads, int pending_size)
+{
+    return createThreadPoolWithQueue(numthreads, pending_size, POOL_QUEUE_MUTEX);
+}
+
+/**
+ * @function createThreadPoolWithQueue
+ * @brief Crea un oggetto thread pool scegliendo l'implementazione della coda dei task pendenti.
+ * @param numthreads è il numero di thread del pool
+ * @param pending_size è la size delle richieste che possono essere pendenti (vedi createThreadPool)
+ * @param queue_type POOL_QUEUE_MUTEX, POOL_QUEUE_LOCKFREE oppure POOL_QUEUE_STEALING
+ *
+ * @return un nuovo thread pool oppure NULL ed errno settato opportunamente
+ */
+threadpool_t *createThreadPoolWithQueue(int numthreads, int pending_size, int queue_type)
+{
+    return createThreadPoolWithProtocol(numthreads, pending_size, queue_type, PROTO_V2);
+}
+
+/**
+ * @function createThreadPoolWithProtocol
+ * @brief Crea un oggetto thread pool scegliendo la coda dei task pendenti e il protocollo verso il collector.
+ * @param numthreads è il numero di thread del pool
+ * @param pending_size è la size delle richieste che possono essere pendenti (vedi createThreadPool)
+ * @param queue_type POOL_QUEUE_MUTEX, POOL_QUEUE_LOCKFREE oppure POOL_QUEUE_STEALING
+ * @param protocol versione massima del protocollo usato dai worker (PROTO_V1, PROTO_V2 o PROTO_V3, communication.h),
+ *                 PROTO_INPROC se i risultati vanno al collector interno alla farm (inproc.h)
+ *
+ * @return un nuovo thread pool oppure NULL ed errno settato opportunamente
+ */
+threadpool_t *createThreadPoolWithProtocol(int numthreads, int pending_size, int queue_type, int protocol)
 {
     // controllo che i parametri siano validi
-    if (numthreads <= 0 || pending_size < 0)
+    if (numthreads <= 0 || pending_size < 0 || queue_type < POOL_QUEUE_MUTEX || queue_type > POOL_QUEUE_STEALING ||
+        protocol < PROTO_INPROC || protocol > PROTO_V3)
     {
         errno = EINVAL;
         return NULL;
@@ -199,6 +670,13 @@ threadpool_t *createThreadPool(int numthreads, int pending_size)
     pool->queue_size = (pending_size == 0 ? -1 : pending_size);
     pool->head = pool->tail = pool->count = 0;
     pool->exiting = 0;
+    pool->queue_type = queue_type;
+    pool->protocol = protocol;
+    pool->pending_queue = NULL;
+    pool->lfq = NULL;
+    pool->deques = NULL;
+    pool->ndeques = pool->next_deque = 0;
+    pool->inflight = pool->sleeping_consumers = pool->sleeping_producers = 0;
 
     /* Allocate thread and task queue */
     pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * numthreads);
@@ -207,9 +685,19 @@ threadpool_t *createThreadPool(int numthreads, int pending_size)
         free(pool);
         return NULL;
     }
-    pool->pending_queue = (taskfun_t *)malloc(sizeof(taskfun_t) * abs(pool->queue_size));
-    if (pool->pending_queue == NULL)
+    if (queue_type == POOL_QUEUE_LOCKFREE)
+        pool->lfq = lfqCreate(abs(pool->queue_size));
+    else if (queue_type == POOL_QUEUE_STEALING)
+    { // una deque per ogni worker
+        if ((pool->deques = malloc(sizeof(wsdeque_t) * numthreads)) != NULL)
+            while (pool->ndeques < numthreads && wsdInit(&pool->deques[pool->ndeques]) == 0)
+                pool->ndeques++;
+    }
+    else
+        pool->pending_queue = (taskfun_t *)malloc(sizeof(taskfun_t) * abs(pool->queue_size));
+    if (pool->pending_queue == NULL && pool->lfq == NULL && pool->ndeques < numthreads)
     {
+        freeQueue(pool);
         free(pool->threads);
         free(pool);
         return NULL;
@@ -219,7 +707,7 @@ threadpool_t *createThreadPool(int numthreads, int pending_size)
     if ((pthread_mutex_init(&(pool->lock), NULL) != 0) || (pthread_cond_init(&(pool->cond_producer), NULL) != 0) || (pthread_cond_init(&(pool->cond_consumer), NULL)))
     {
         free(pool->threads);
-        free(pool->pending_queue);
+        freeQueue(pool);
         free(pool);
         return NULL;
     }
@@ -257,7 +745,8 @@ int destroyThreadPool(threadpool_t *pool, int force)
 
     LOCK_RETURN(&(pool->lock), -1); // acquisisco la lock
 
-    pool->exiting = 1 + force; // imposto la variabile di terminazione
+    // imposto la variabile di terminazione (letta senza lock dal backend lock-free)
+    __atomic_store_n(&pool->exiting, 1 + force, __ATOMIC_SEQ_CST);
 
     if (pthread_cond_broadcast(&(pool->cond_consumer)) != 0)
     { // risveglio tutti i thread bloccati sulla variabile di condizione
@@ -304,57 +793,124 @@ int addToThreadPool(threadpool_t *pool, int (*f)(void *, void *), void *arg)
         return -1;
     }
 
-    LOCK_RETURN(&(pool->lock), -1);
-    int queue_size = abs(pool->queue_size);
-    int nopending = (pool->queue_size == -1); // non dobbiamo gestire messaggi pendenti
-
-    // finchè la coda è piena e non devo uscire mi sospendo
-    while (pool->count >= queue_size && (!pool->exiting))
+    // copio il pathname, la copia viene liberata dal worker dopo l'esecuzione del task
+    char *str_temp = pathDup((char *)arg);
+    if (str_temp == NULL)
     {
-        pthread_cond_wait(&(pool->cond_producer), &(pool->lock));
+        perror("pathDup");
+        return -1;
     }
 
-    // in fase di uscita
-    if (pool->exiting)
+    int r = addTaskToThreadPool(pool, f, str_temp);
+    if (r != 0)
+        pathFree(str_temp);
+    return r;
+}
+
+/**
+ * @function addTaskToThreadPool
+ * @brief aggiunge un task al pool senza copiarne l'argomento
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per eseguire il task
+ * @param arg  argomento della funzione allocato con pathAlloc/pathDup, in caso di successo viene liberato dal worker dopo l'esecuzione del task
+ * @return 0 se successo, 1 se non ci sono thread disponibili e/o la coda è piena, -1 in caso di fallimento, errno viene settato opportunamente.
+ */
+int addTaskToThreadPool(threadpool_t *pool, int (*f)(void *, void *), void *arg)
+{
+    if (pool == NULL || f == NULL || arg == NULL)
     {
-        UNLOCK_RETURN(&(pool->lock), -1);
-        return 1; // esco con valore "coda piena" (non ho aggiunto)
+        errno = EINVAL;
+        return -1;
     }
 
-    if (pool->taskonthefly >= pool->numthreads) // tutti i thread sono occupati
-    {
-        if (nopending)
-        {
-            // tutti i thread sono occupati e non si gestiscono task pendenti
-            assert(pool->count == 0);
+    if (pool->queue_type == POOL_QUEUE_LOCKFREE)
+        return lf_add(pool, f, arg, 1);
+    if (pool->queue_type == POOL_QUEUE_STEALING)
+        return ws_add(pool, f, arg, 1);
+    return mutex_add(pool, f, arg);
+}
 
-            UNLOCK_RETURN(&(pool->lock), -1);
-            return 1; // esco con valore "coda piena"
-        }
+/**
+ * @function addManyToThreadPool
+ * @brief aggiunge al pool un lotto di task, copiandone gli argomenti come addToThreadPool
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per ciascun task
+ * @param args argomenti delle funzioni (pathname dei file su cui si deve lavorare)
+ * @param n    numero di task del lotto
+ * @return il numero di task aggiunti (i primi del lotto, meno di n se il pool e' in uscita o non ci sono thread disponibili), -1 in caso di fallimento, errno viene settato opportunamente.
+ */
+int addManyToThreadPool(threadpool_t *pool, int (*f)(void *, void *), void *args[], int n)
+{
+    if (pool == NULL || f == NULL || args == NULL || n < 0)
+    {
+        errno = EINVAL;
+        return -1;
     }
-    // inserisco in coda
-    pool->pending_queue[pool->tail].fun = (int (*)(void *, void *))f;
-    char *str_temp = (char *)malloc(sizeof(char) * NAME_MAX);
-    if (str_temp == NULL)
+
+    char **copies = (char **)malloc(sizeof(char *) * (n > 0 ? n : 1));
+    if (copies == NULL)
     {
         perror("malloc");
-        UNLOCK_RETURN(&(pool->lock), -1);
         return -1;
     }
-    pool->pending_queue[pool->tail].arg = strcpy(str_temp, (char *)arg);
-    pool->count++; // incremento il numero dei task pendenti
-    pool->tail++;  // incremento il puntatore alla coda
-    if (pool->tail >= queue_size)
-        pool->tail = 0;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        if ((copies[i] = pathDup((char *)args[i])) == NULL)
+        {
+            perror("pathDup");
+            break;
+        }
+    }
 
-    int r;
-    if ((r = pthread_cond_signal(&(pool->cond_consumer))) != 0)
-    { // faccio una signal per svegliare un worker in attesa
-        UNLOCK_RETURN(&(pool->lock), -1);
-        errno = r;
+    int r = (i < n) ? -1 : addManyTasksToThreadPool(pool, f, (void **)copies, n);
+    for (int j = (r > 0 ? r : 0); j < i; j++)
+        pathFree(copies[j]); // gli argomenti non aggiunti restano al chiamante
+    free(copies);
+    return r;
+}
+
+/**
+ * @function addManyTasksToThreadPool
+ * @brief aggiunge al pool un lotto di task senza copiarne gli argomenti. Con il backend POOL_QUEUE_MUTEX l'intero lotto
+ *        viene inserito con una sola acquisizione del lock e un solo broadcast, con gli altri backend i worker vengono
+ *        svegliati una sola volta alla fine del lotto.
+ * @param pool oggetto thread pool
+ * @param fun  funzione da eseguire per ciascun task
+ * @param args argomenti allocati con pathAlloc/pathDup, quelli dei task aggiunti vengono liberati dal worker dopo l'esecuzione
+ * @param n    numero di task del lotto
+ * @return il numero di task aggiunti (i primi del lotto), -1 in caso di fallimento, errno viene settato opportunamente.
+ */
+int addManyTasksToThreadPool(threadpool_t *pool, int (*f)(void *, void *), void *args[], int n)
+{
+    if (pool == NULL || f == NULL || args == NULL || n < 0)
+    {
+        errno = EINVAL;
         return -1;
     }
+    if (n == 0)
+        return 0;
 
-    UNLOCK_RETURN(&(pool->lock), -1);
-    return 0;
+    if (pool->queue_type == POOL_QUEUE_MUTEX)
+        return mutex_add_many(pool, f, args, n);
+
+    int added = 0, r = 0;
+    while (added < n)
+    {
+        r = (pool->queue_type == POOL_QUEUE_LOCKFREE) ? lf_add(pool, f, args[added], 0) : ws_add(pool, f, args[added], 0);
+        if (r != 0)
+            break;
+        added++;
+    }
+    if (added > 0)
+    { // un solo risveglio per tutto il lotto
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pool->sleeping_consumers, __ATOMIC_SEQ_CST) > 0)
+        {
+            pthread_mutex_lock(&(pool->lock));
+            pthread_cond_broadcast(&(pool->cond_consumer));
+            pthread_mutex_unlock(&(pool->lock));
+        }
+    }
+    return (r == -1 && added == 0) ? -1 : added;
 }
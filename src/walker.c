@@ -0,0 +1,242 @@
+/**********************************/
+//  implementation file walker.c   /
+/*================================*/
+
+#define _GNU_SOURCE // openat, fdopendir, fstatat e d_type
+
+// include
+#include <util.h>
+#include <walker.h>
+#include <pathalloc.h>
+#include <pthread.h>
+#include <fcntl.h>
+
+// numero massimo di directory in coda che restano aperte (le altre vengono riaperte tramite il pathname)
+#define WALK_MAX_OPEN 64
+
+/**
+ *  @struct walkdir_t
+ *  @brief directory in attesa di essere letta
+ *
+ *  @var next elemento successivo della coda
+ *  @var fd   directory gia' aperta con openat, -1 se va aperta tramite path
+ *  @var path pathname della directory
+ */
+typedef struct walkdir_t
+{
+    struct walkdir_t *next;
+    int fd;
+    char path[];
+} walkdir_t;
+
+/**
+ *  @struct walker_t
+ *  @brief stato condiviso dai thread di esplorazione
+ *
+ *  @var lock   mutua esclusione sulla coda
+ *  @var cond   segnala una nuova directory in coda o la fine dell'esplorazione
+ *  @var head   testa della coda delle directory da leggere
+ *  @var tail   fondo della coda
+ *  @var active thread che stanno leggendo una directory (possono ancora inserirne di nuove)
+ *  @var open   directory in coda gia' aperte
+ *  @var ops    callback dell'esplorazione
+ */
+typedef struct walker_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    walkdir_t *head;
+    walkdir_t *tail;
+    int active;
+    int open;
+    const walker_ops_t *ops;
+} walker_t;
+
+static int stopped(const walker_ops_t *ops)
+{
+    return ops->stop != NULL && *ops->stop;
+}
+
+// inserisce in coda la directory path, di nome name nella directory parentfd (-1 per la radice)
+static int enqueue(walker_t *w, int parentfd, const char *name, const char *path)
+{
+    size_t len = strlen(path) + 1;
+    walkdir_t *d = malloc(sizeof(walkdir_t) + len);
+    if (d == NULL)
+    {
+        perror("malloc");
+        return -1;
+    }
+    memcpy(d->path, path, len);
+    d->next = NULL;
+    d->fd = -1;
+    if (parentfd != -1 && __atomic_add_fetch(&w->open, 1, __ATOMIC_RELAXED) <= WALK_MAX_OPEN)
+        d->fd = openat(parentfd, name, O_RDONLY | O_DIRECTORY);
+    if (parentfd != -1 && d->fd == -1)
+        __atomic_sub_fetch(&w->open, 1, __ATOMIC_RELAXED); // verra' aperta (o segnalato l'errore) tramite il pathname
+
+    pthread_mutex_lock(&w->lock);
+    if (w->tail == NULL)
+        w->head = d;
+    else
+        w->tail->next = d;
+    w->tail = d;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
+
+// legge la directory d: inserisce in coda le sottodirectory e passa i file regolari alla callback
+static void walk_dir(walker_t *w, walkdir_t *d)
+{
+    const walker_ops_t *ops = w->ops;
+    int fd = d->fd;
+    if (fd != -1)
+        __atomic_sub_fetch(&w->open, 1, __ATOMIC_RELAXED);
+    else
+        fd = open(d->path, O_RDONLY | O_DIRECTORY);
+
+    DIR *dir = (fd == -1) ? NULL : fdopendir(fd);
+    if (dir == NULL)
+    {
+        if (fd != -1)
+            close(fd);
+        print_error("Errore aprendo la directory %s\n", d->path);
+        return;
+    }
+
+    char path[PATH_MAX];
+    size_t plen = strlen(d->path);
+    const char *sep = (plen > 0 && d->path[plen - 1] != '/') ? "/" : "";
+    struct dirent *file = NULL;
+
+    while (!stopped(ops) && (errno = 0, file = readdir(dir)) != NULL)
+    {
+        if (snprintf(path, PATH_MAX, "%s%s%s", d->path, sep, file->d_name) >= PATH_MAX)
+        {
+            print_error("Pathname troppo lungo in %s: %s\n", d->path, file->d_name);
+            continue;
+        }
+
+        // il tipo dell'entry e' noto da d_type, la stat serve solo se non lo e' (o per i link simbolici, che
+        // vengono seguiti) oppure se il chiamante vuole la dimensione dei file
+        struct stat statbuf;
+        const struct stat *st = NULL;
+        int isdir = (file->d_type == DT_DIR);
+        int isreg = (file->d_type == DT_REG);
+        if (file->d_type == DT_UNKNOWN || file->d_type == DT_LNK || (isreg && ops->need_stat))
+        {
+            if (fstatat(fd, file->d_name, &statbuf, 0) == -1)
+            {
+                perror("fstatat");
+                print_error("Errore facendo stat di %s\n", path);
+                continue;
+            }
+            isdir = S_ISDIR(statbuf.st_mode);
+            isreg = S_ISREG(statbuf.st_mode);
+            st = &statbuf;
+        }
+
+        if (isdir)
+        {
+            if (!isdot(file->d_name)) // se non è la directory corrente o padre
+                enqueue(w, fd, file->d_name, path);
+        }
+        else if (isreg)
+            ops->file(path, st, ops->arg);
+    }
+    if (file == NULL && errno != 0)
+        perror("readdir");
+    closedir(dir);
+
+    if (ops->dir_done != NULL)
+        ops->dir_done(ops->arg);
+}
+
+// thread di esplorazione: legge directory dalla coda finche' la coda e' vuota e nessun thread ne puo' inserire altre
+static void *walker_thread(void *arg)
+{
+    walker_t *w = (walker_t *)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&w->lock);
+        while (w->head == NULL && w->active > 0 && !stopped(w->ops))
+            pthread_cond_wait(&w->cond, &w->lock);
+        walkdir_t *d = w->head;
+        if (d == NULL || stopped(w->ops))
+        { // esplorazione finita (o interrotta): sveglio gli altri thread perche' escano anche loro
+            pthread_cond_broadcast(&w->cond);
+            pthread_mutex_unlock(&w->lock);
+            pathallocThreadFlush(); // le callback allocano i pathname con pathDup/pathAlloc
+            return NULL;
+        }
+        w->head = d->next;
+        if (w->head == NULL)
+            w->tail = NULL;
+        w->active++;
+        pthread_mutex_unlock(&w->lock);
+
+        walk_dir(w, d);
+        free(d);
+
+        pthread_mutex_lock(&w->lock);
+        w->active--;
+        if ((w->active == 0 && w->head == NULL) || stopped(w->ops))
+            pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+}
+
+int walkTree(const char *root, int nthreads, const walker_ops_t *ops)
+{
+    if (root == NULL || ops == NULL || ops->file == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (nthreads < 1)
+        nthreads = 1;
+
+    walker_t w;
+    w.head = w.tail = NULL;
+    w.active = 0;
+    w.open = 0;
+    w.ops = ops;
+    if (pthread_mutex_init(&w.lock, NULL) != 0)
+        return -1;
+    if (pthread_cond_init(&w.cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&w.lock);
+        return -1;
+    }
+    if (enqueue(&w, -1, root, root) == -1)
+    {
+        pthread_cond_destroy(&w.cond);
+        pthread_mutex_destroy(&w.lock);
+        return -1;
+    }
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    int started = 0;
+    if (threads != NULL)
+        while (started < nthreads && pthread_create(&threads[started], NULL, walker_thread, &w) == 0)
+            started++;
+    if (started == 0)
+        walker_thread(&w); // nessun thread avviato: esploro nel thread chiamante
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+
+    // directory rimaste in coda se l'esplorazione e' stata interrotta
+    while (w.head != NULL)
+    {
+        walkdir_t *d = w.head;
+        w.head = d->next;
+        if (d->fd != -1)
+            close(d->fd);
+        free(d);
+    }
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.lock);
+    return 0;
+}
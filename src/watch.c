@@ -0,0 +1,211 @@
+/*********************************/
+//  implementation file watch.c   /
+/*===============================*/
+
+#define _GNU_SOURCE // d_type
+
+// include
+#include <util.h>
+#include <watch.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+// eventi osservati su ogni directory: file scritti e chiusi, entry spostate nella directory, sottodirectory create
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR)
+
+/**
+ *  @struct watcher_t
+ *  @brief osservatore di un albero di directory
+ *
+ *  @var fd    descrittore inotify (non bloccante)
+ *  @var paths pathname della directory di ciascun watch, indicizzati con il watch descriptor
+ *  @var npath dimensione di paths
+ */
+struct watcher_t
+{
+    int fd;
+    char **paths;
+    int npath;
+};
+
+static int stopped(const walker_ops_t *ops)
+{
+    return ops != NULL && ops->stop != NULL && *ops->stop;
+}
+
+// passa alla callback il file path se e' un file regolare
+static void report(const char *path, const walker_ops_t *ops)
+{
+    struct stat st;
+    if (stat(path, &st) == -1)
+    { // il file puo' essere gia' stato rimosso
+        if (errno != ENOENT)
+            perror("stat");
+        return;
+    }
+    if (S_ISREG(st.st_mode))
+        ops->file(path, &st, ops->arg);
+}
+
+/**
+ * funzione add_dir
+ * @brief osserva la directory path e, ricorsivamente, le sue sottodirectory. Se ops non e' NULL i file regolari
+ *        gia' presenti vengono passati alla callback (directory comparsa mentre la farm la osservava)
+ * @return 0 in caso di successo, -1 se non e' stato possibile osservare path
+ */
+static int add_dir(watcher_t *w, const char *path, const walker_ops_t *ops)
+{
+    int wd = inotify_add_watch(w->fd, path, WATCH_MASK);
+    if (wd == -1)
+    {
+        perror("inotify_add_watch");
+        return -1;
+    }
+    if (wd >= w->npath)
+    {
+        int n = (wd + 1) * 2;
+        char **p = realloc(w->paths, n * sizeof(char *));
+        if (p == NULL)
+        {
+            inotify_rm_watch(w->fd, wd);
+            return -1;
+        }
+        memset(p + w->npath, 0, (n - w->npath) * sizeof(char *));
+        w->paths = p;
+        w->npath = n;
+    }
+    if (w->paths[wd] == NULL && (w->paths[wd] = strdup(path)) == NULL)
+    {
+        inotify_rm_watch(w->fd, wd);
+        return -1;
+    }
+
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+    {
+        perror("opendir");
+        return 0; // il watch resta, mancano solo i file gia' presenti
+    }
+    struct dirent *e;
+    char child[PATH_MAX];
+    while ((e = readdir(dir)) != NULL && !stopped(ops))
+    {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+            continue;
+        if (snprintf(child, sizeof(child), "%s/%s", path, e->d_name) >= (int)sizeof(child))
+            continue;
+        int isdir = (e->d_type == DT_DIR);
+        if (e->d_type == DT_UNKNOWN)
+        { // il file system non fornisce il tipo, i link simbolici a directory non vengono seguiti
+            struct stat st;
+            isdir = (lstat(child, &st) == 0 && S_ISDIR(st.st_mode));
+        }
+        if (isdir)
+            add_dir(w, child, ops);
+        else if (ops != NULL)
+            report(child, ops);
+    }
+    closedir(dir);
+    return 0;
+}
+
+watcher_t *watchCreate(const char *root)
+{
+    watcher_t *w = malloc(sizeof(watcher_t));
+    if (w == NULL)
+        return NULL;
+    w->paths = NULL;
+    w->npath = 0;
+    if ((w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1)
+    {
+        free(w);
+        return NULL;
+    }
+    if (add_dir(w, root, NULL) == -1)
+    {
+        int errtemp = errno;
+        watchDestroy(w);
+        errno = errtemp;
+        return NULL;
+    }
+    return w;
+}
+
+// gestisce un evento letto dal descrittore inotify
+static void handle(watcher_t *w, const struct inotify_event *ev, const walker_ops_t *ops)
+{
+    if (ev->mask & IN_Q_OVERFLOW)
+    {
+        fprintf(stderr, "watch: coda degli eventi piena, alcuni file potrebbero non essere elaborati\n");
+        return;
+    }
+    if (ev->wd < 0 || ev->wd >= w->npath || w->paths[ev->wd] == NULL)
+        return;
+    if (ev->mask & IN_IGNORED)
+    { // la directory e' stata rimossa
+        free(w->paths[ev->wd]);
+        w->paths[ev->wd] = NULL;
+        return;
+    }
+    if (ev->len == 0)
+        return;
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", w->paths[ev->wd], ev->name) >= (int)sizeof(path))
+        return;
+    if (ev->mask & IN_ISDIR)
+    {
+        if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+            add_dir(w, path, ops);
+    }
+    else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+        report(path, ops);
+}
+
+int watchRun(watcher_t *w, const walker_ops_t *ops)
+{
+    union
+    { // buffer degli eventi allineato come una inotify_event
+        struct inotify_event align;
+        char buf[64 * 1024];
+    } u;
+    struct pollfd pfd = {w->fd, POLLIN, 0};
+
+    while (!stopped(ops))
+    {
+        // il timeout permette di controllare il flag di terminazione settato dal signal handler
+        int r = poll(&pfd, 1, WATCH_POLL_MS);
+        if (r == -1 && errno != EINTR)
+            return -1;
+        if (r <= 0)
+            continue;
+
+        ssize_t n;
+        while ((n = read(w->fd, u.buf, sizeof(u.buf))) > 0)
+        {
+            for (char *p = u.buf; p < u.buf + n && !stopped(ops);)
+            {
+                const struct inotify_event *ev = (const struct inotify_event *)p;
+                handle(w, ev, ops);
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        if (n == -1 && errno != EAGAIN && errno != EINTR)
+            return -1;
+        if (ops->dir_done != NULL)
+            ops->dir_done(ops->arg);
+    }
+    return 0;
+}
+
+void watchDestroy(watcher_t *w)
+{
+    if (w == NULL)
+        return;
+    close(w->fd); // rimuove tutti i watch
+    for (int i = 0; i < w->npath; i++)
+        free(w->paths[i]);
+    free(w->paths);
+    free(w);
+}
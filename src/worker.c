@@ -2,14 +2,264 @@
 //  implementation file worker.c   /
 /*================================*/
 
+#define _GNU_SOURCE // madvise e MADV_SEQUENTIAL non fanno parte di POSIX
+
 // include
 #include <util.h>
 #include <worker.h>
+#include <wsum.h>
+#include <pathalloc.h>
+#include <fcntl.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+
+// dimensione (in numero di long) del buffer usato dal percorso di fallback basato su read
+#define READ_BUF_LONGS 8192
+
+// numero di long da leggere per indicare "fino alla fine del file" (file non regolari)
+#define READ_TO_EOF ((size_t)-1)
+
+// punto di ripresa del thread che sta leggendo un file mappato, NULL fuori dalla lettura
+static __thread sigjmp_buf *volatile bus_env = NULL;
+static pthread_once_t bus_once = PTHREAD_ONCE_INIT;
+
+// un file troncato mentre e' mappato genera SIGBUS sul thread che ne legge le pagine oltre la nuova fine
+static void bus_handler(int signum)
+{
+    if (bus_env != NULL)
+        siglongjmp(*bus_env, 1);
+    // SIGBUS non dovuto alla lettura di un file: ripristino il comportamento di default, che termina al ritorno
+    signal(signum, SIG_DFL);
+}
+
+static void bus_install(void)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = bus_handler;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGBUS, &sa, NULL) == -1)
+        perror("sigaction");
+}
+
+/**
+ * @brief: esegue la computazione su un intervallo di long del file mappandolo in memoria, i long vengono letti
+ *         direttamente dalle pagine del page cache senza passare da stdio e senza syscall per ogni elemento
+ * @param fd file descriptor del file (aperto in lettura)
+ * @param first indice del primo long dell'intervallo
+ * @param nelem numero di long dell'intervallo
+ * @param result puntatore a long dove memorizzare il risultato
+ * @return 0 in caso di successo, -1 se il file non puo' essere mappato o e' stato troncato durante la lettura
+ *         (errno settato): in entrambi i casi il chiamante ripiega su read
+ */
+static int compute_mmap(int fd, long first, size_t nelem, long *result)
+{
+    pthread_once(&bus_once, bus_install);
+
+    // l'offset di mmap deve essere multiplo della dimensione di pagina
+    off_t offset = (off_t)first * sizeof(long);
+    off_t aligned = offset & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+    size_t delta = offset - aligned;
+    size_t len = delta + nelem * sizeof(long);
+
+    char *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, aligned);
+    if (p == MAP_FAILED)
+        return -1;
+
+    /*
+     * man madvise
+     * MADV_SEQUENTIAL
+     *    Expect page references in sequential order.  (Hence, pages in the given range can be
+     *    aggressively read ahead, and may be freed soon after they are accessed.)
+     *
+     * e' solo un suggerimento al kernel, un eventuale errore non pregiudica la computazione
+     */
+    madvise(p, len, MADV_SEQUENTIAL);
+
+    sigjmp_buf env;
+    if (sigsetjmp(env, 1) != 0)
+    { // SIGBUS: il file si e' accorciato, read legge quello che ne resta
+        bus_env = NULL;
+        munmap(p, len);
+        errno = EIO;
+        return -1;
+    }
+    bus_env = &env;
+    *result = wsum((const long *)(p + delta), nelem, first);
+    bus_env = NULL;
+
+    munmap(p, len);
+    return 0;
+}
+
+/**
+ * @brief: esegue la computazione su un intervallo di long del file leggendolo a blocchi con read,
+ *         usata quando il file non puo' essere mappato in memoria
+ * @param fd file descriptor del file (aperto in lettura, posizionato all'inizio)
+ * @param first indice del primo long dell'intervallo
+ * @param nelem numero di long dell'intervallo, READ_TO_EOF per leggere fino alla fine del file
+ * @param result puntatore a long dove memorizzare il risultato
+ * @return 0 in caso di successo, -1 in caso di errore (errno settato)
+ */
+static int compute_read(int fd, long first, size_t nelem, long *result)
+{
+    long buf[READ_BUF_LONGS];
+    char *bytes = (char *)buf;
+    size_t have = 0; // byte validi nel buffer
+    unsigned long sum = 0;
+    long i = first;
+    ssize_t r;
+
+    if (first > 0 && lseek(fd, (off_t)first * sizeof(long), SEEK_SET) == -1)
+        return -1;
+
+    while (nelem > 0)
+    {
+        size_t want = sizeof(buf) - have;
+        if (nelem != READ_TO_EOF && want > nelem * sizeof(long) - have)
+            want = nelem * sizeof(long) - have;
+        if ((r = read(fd, bytes + have, want)) == 0)
+            break;
+        if (r == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        have += r;
+        size_t n = have / sizeof(long);
+        sum += (unsigned long)wsum(buf, n, i);
+        i += n;
+        if (nelem != READ_TO_EOF)
+            nelem -= n;
+        // l'eventuale long letto solo in parte viene spostato in testa al buffer
+        have -= n * sizeof(long);
+        memmove(bytes, bytes + n * sizeof(long), have);
+    }
+    // come con fread, gli eventuali byte finali che non formano un long vengono ignorati
+    *result = (long)sum;
+    return 0;
+}
+
+/**
+ * @brief: calcola la somma pesata dei long [first, first + nelem) del file, prima con mmap e in caso
+ *         di fallimento con read
+ * @return 0 in caso di successo, -1 in caso di errore (errno settato)
+ */
+static int compute_range(int fd, int mappable, long first, size_t nelem, long *result)
+{
+    if (nelem == 0)
+    { // un intervallo vuoto non puo' essere mappato ed ha risultato 0
+        *result = 0;
+        return 0;
+    }
+    if (mappable && compute_mmap(fd, first, nelem, result) == 0)
+        return 0;
+    // fallback: il file non e' mappabile, lo leggo a blocchi
+    return compute_read(fd, first, nelem, result);
+}
+
+/**
+ * @brief: contabilizza su un job il risultato di nchunks chunk
+ *         (eseguiti con successo se cancel e' 0, falliti o mai sottomessi altrimenti).
+ *         Chi porta a zero il numero di chunk pendenti chiude il job: se nessun chunk e' stato
+ *         cancellato il risultato complessivo viene restituito in res, altrimenti il file e' scartato.
+ * @return TASK_DONE se res contiene il risultato da inviare, TASK_PARTIAL altrimenti
+ */
+static int chunkjob_account(chunkjob_t *job, long partial, long nchunks, int cancel, taskres_t *res)
+{
+    pthread_mutex_lock(&job->lock);
+    job->sum += (unsigned long)partial;
+    job->pending -= nchunks;
+    job->cancelled |= cancel;
+    int last = (job->pending == 0);
+    pthread_mutex_unlock(&job->lock);
+
+    if (!last)
+        return TASK_PARTIAL;
+
+    int ret = TASK_PARTIAL;
+    if (!job->cancelled && res != NULL)
+    { // il nome passa al pool che lo libera dopo l'invio
+        rcacheStore(&job->key, (long)job->sum, job->check);
+        res->sum = (long)job->sum;
+        res->name = job->file_name;
+        ret = TASK_DONE;
+    }
+    else
+        pathFree(job->file_name);
+    pthread_mutex_destroy(&job->lock);
+    free(job);
+    return ret;
+}
+
+chunkjob_t *newChunkJob(const char *file_name, const struct stat *st, long nchunks)
+{
+    chunkjob_t *job = malloc(sizeof(chunkjob_t));
+    if (job == NULL)
+        return NULL;
+    if ((job->file_name = pathDup(file_name)) == NULL)
+    { // il nome diventa il nome del risultato e viene liberato dal pool con pathFree
+        free(job);
+        return NULL;
+    }
+    job->sum = 0;
+    job->pending = nchunks;
+    job->cancelled = 0;
+    rcacheKey(st, &job->key);
+    job->check = 0;
+    if (pthread_mutex_init(&job->lock, NULL) != 0)
+    {
+        pathFree(job->file_name);
+        free(job);
+        return NULL;
+    }
+    return job;
+}
+
+void cancelChunks(chunkjob_t *job, long nchunks)
+{
+    chunkjob_account(job, 0, nchunks, 1, NULL);
+}
+
+int compute_chunk(chunk_t *chunk, taskres_t *res)
+{
+    chunkjob_t *job = chunk->job;
+    long partial = 0;
+
+    // un chunk dello stesso file e' gia' fallito: il file e' scartato, non serve leggere questo
+    pthread_mutex_lock(&job->lock);
+    int cancelled = job->cancelled;
+    pthread_mutex_unlock(&job->lock);
+    if (cancelled)
+        return chunkjob_account(job, 0, 1, 1, NULL);
+
+    int fd = open(job->file_name, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("ERROR with open in compute_chunk function");
+        // il file viene scartato ma il worker prosegue, come per i file di compute_listed
+        return chunkjob_account(job, 0, 1, 1, NULL);
+    }
+    if (compute_range(fd, 1, chunk->first, chunk->count, &partial) == -1)
+    {
+        perror("error in read in compute_chunk function");
+        close(fd);
+        return chunkjob_account(job, 0, 1, 1, NULL);
+    }
+    // l'ultimo chunk del file contiene i long del controllo per la cache, letto da chi chiude il job dopo la lock
+    if (job->key.size / (long)sizeof(long) == chunk->first + chunk->count && rcacheEnabled())
+        job->check = rcacheCheck(fd, chunk->first + chunk->count);
+    close(fd);
+
+    return chunkjob_account(job, partial, 1, 0, res);
+}
 
 /**
  * @brief: la funzione compute implementa il lavoro che un thread worker deve compiere
  *         la funzione prende in ingresso il pathname di un file regolare, il file viene interpretato come un file binario contenente N long
- *         i long contenuti nel file vengono letti uno ad uno e con essi viene eseguita una computazione
+ *         il file viene mappato in memoria (mmap) e la computazione viene eseguita direttamente sull'array di long mappato,
+ *         se il file non puo' essere mappato si ripiega su una lettura a blocchi con read
  *         Il calcolo che deve essere effettuato su ogni file è il seguente result = sommatoria (per i che va da 0 a N-1) di (i * file[i])
  *         N è il numero di long presenti nel file e file[i] è l' i-esimo long
  * @param file_name il pathname del file su cui operare
@@ -18,7 +268,8 @@
  *          -1 se si è verificato un errore
  */
 
-int compute(char *file_name, long *result)
+// corpo di compute e compute_listed: con regular_only un file che non e' regolare viene scartato e ritorna 1
+static int compute_file(char *file_name, int regular_only, long *result)
 {
     // controllo che gli argomenti passati non siano null
     if (file_name == NULL || result==NULL)
@@ -27,105 +278,102 @@ int compute(char *file_name, long *result)
         return -1; // segnalo l'errore al chiamante 
     }
 
-    // file da aprire
-    FILE *fptr;
-
     // apro il file in lettura
-    fptr = fopen(file_name, "r");
-
-    /* from the man ...
-    FILE *fopen(const char *pathname, const char *mode);
-    DESCRIPTION
-       The fopen() function opens the file whose name is the string pointed to by pathname and associates a
-       stream with it.
-
-       The argument mode points to a string beginning with one of the following  sequences  (possibly  fol‐
-       lowed by additional characters, as described below):
-
-       
-       r      Open text file for reading.  The stream is positioned at the beginning of the file.
-
-       r+     Open for reading and writing.  The stream is positioned at the beginning of the file.
-
-       w      Truncate  file  to  zero length or create text file for writing.  The stream is positioned at
-              the beginning of the file.
-
-       w+     Open for reading and writing.  The file is created if it does  not  exist,  otherwise  it  is
-              truncated.  The stream is positioned at the beginning of the file.
-
-       a      Open  for appending (writing at end of file).  The file is created if it does not exist.  The
-              stream is positioned at the end of the file.
-
-       a+     Open for reading and appending (writing at end of file).  The file is created if it does  not
-              exist.   Output  is always appended to the end of the file.  POSIX is silent on what the ini‐
-              tial read position is when using this mode.  For glibc, the initial file position for reading
-              is  at  the  beginning  of the file, but for Android/BSD/MacOS, the initial file position for
-              reading is at the end of the file.
-    
-
-       ...
-    */
-
-    if (fptr == NULL)
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1)
     {
-        perror("ERROR with fopen in compute function");
+        perror("ERROR with open in compute function");
         return -1;
     }
 
-    // <uso del file>
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) == -1)
+    {
+        int errtemp = errno;
+        perror("ERROR with fstat in compute function");
+        close(fd);
+        errno = errtemp;
+        return -1;
+    }
+    if (regular_only && !S_ISREG(statbuf.st_mode))
+    {
+        fprintf(stderr, "%s non e' un file regolare\n", file_name);
+        close(fd);
+        return 1;
+    }
 
-    // variabili di supporto
-    long tmp;
     long sum = 0;
-    long i = 0;
-    int r;
+    // solo i file regolari hanno una dimensione nota e possono essere mappati
+    int mappable = S_ISREG(statbuf.st_mode);
+    size_t nelem = mappable ? statbuf.st_size / sizeof(long) : READ_TO_EOF;
+    rckey_t key;
+    rcacheKey(&statbuf, &key);
 
-    // riazzero errno
-    errno = 0;
-    // leggo un long alla volta dal file binario 
-    /*
-    * man fread 
-    * size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
-    * size_t fwrite(const void *ptr, size_t size, size_t nmemb,FILE *stream);
-    * DESCRIPTION
-       The  function fread() reads nmemb items of data, each size bytes long, from the stream pointed to by
-       stream, storing them at the location given by ptr.
-
-       The function fwrite() writes nmemb items of data, each size bytes long, to the stream pointed to  by
-       stream, obtaining them from the location given by ptr.
-
-       For nonlocking counterparts, see unlocked_stdio(3).
-
-       RETURN VALUE
-       On success, fread() and fwrite() return the number of items read or written. This number equals the
-       number of bytes transferred only when size is 1.  If an error occurs, or the  end  of  the  file  is
-       reached, the return value is a short item count (or zero). 
-
-       The  file  position indicator for the stream is advanced by the number of bytes successfully read or
-       written.
-
-       fread() does not distinguish between end-of-file and error, and callers must use  feof(3)  and  fer‐
-       ror(3) to determine which occurred.
-    */
-    while ((r = fread(&tmp, sizeof(long), 1, fptr)) != 0)
-    {
-        sum += i * tmp;
-        i++;
-    }
-    if (errno != 0)
+    // modalita' incrementale: se il vecchio prefisso non e' cambiato riprendo il calcolo dalla sua fine
+    long first = 0, prefix = 0;
+    long psize;
+    unsigned long pcheck;
+    if (mappable && rcacheIncremental() && rcachePrefix(&key, &psize, &prefix, &pcheck) &&
+        rcacheCheck(fd, psize / sizeof(long)) == pcheck)
+        first = psize / sizeof(long);
+    else
+        prefix = 0;
+
+    if (compute_range(fd, mappable, first, nelem - first, &sum) == -1)
     {
         int errtemp = errno;
-        // stampa errore
-        perror("error in fread in compute function");
-        fclose(fptr);
+        perror("error in read in compute function");
+        close(fd);
         errno = errtemp;
         return -1;
     }
 
-    fclose(fptr);
+    sum = (long)((unsigned long)sum + (unsigned long)prefix); // il risultato del prefisso si somma a quello della coda
+
+    // la chiave e' quella della fstat fatta prima della lettura: se il file e' cambiato nel frattempo
+    // il suo mtime non coincide piu' e alla prossima esecuzione verra' ricalcolato
+    if (mappable && rcacheEnabled())
+        rcacheStore(&key, sum, rcacheCheck(fd, nelem));
+
+    close(fd);
     // printf("File : %s --> result :%ld\n", file_name, sum);
 
     *result = sum;
     
     return 0; //success
-}
\ No newline at end of file
+}
+
+int compute(char *file_name, long *result)
+{
+    return compute_file(file_name, 0, result);
+}
+
+int compute_listed(char *file_name, taskres_t *res)
+{
+    // un file dell'elenco che non esiste o non puo' essere letto viene scartato senza terminare il worker
+    return compute_file(file_name, 1, &res->sum) == 0 ? TASK_DONE : TASK_PARTIAL;
+}
+
+// il risultato segue il pathname, allineato come un long
+static size_t cached_offset(const char *file_name)
+{
+    size_t len = strlen(file_name) + 1;
+    return (len + sizeof(long) - 1) / sizeof(long) * sizeof(long);
+}
+
+char *newCachedTask(const char *file_name, long result)
+{
+    size_t off = cached_offset(file_name);
+    char *arg = pathAlloc(off + sizeof(long));
+    if (arg == NULL)
+        return NULL;
+    strcpy(arg, file_name);
+    memcpy(arg + off, &result, sizeof(long));
+    return arg;
+}
+
+int cached_result(char *arg, taskres_t *res)
+{
+    memcpy(&res->sum, arg + cached_offset(arg), sizeof(long));
+    return TASK_DONE; // res->name e' gia' arg, che inizia con il pathname
+}
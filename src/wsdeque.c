@@ -0,0 +1,93 @@
+/***********************************/
+//  implementation file wsdeque.c   /
+/*=================================*/
+
+// include
+#include <util.h>
+#include <wsdeque.h>
+
+// capacita' iniziale di una deque
+#define WSD_INIT_CAP 16
+
+// numero di task nella deque, letto senza lock per evitare di bloccare la deque quando e' vuota
+static size_t wsdSize(wsdeque_t *d)
+{
+    return __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE) - __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+}
+
+int wsdInit(wsdeque_t *d)
+{
+    if ((d->buf = malloc(sizeof(taskfun_t) * WSD_INIT_CAP)) == NULL)
+        return -1;
+    int r;
+    if ((r = pthread_mutex_init(&d->lock, NULL)) != 0)
+    {
+        free(d->buf);
+        errno = r;
+        return -1;
+    }
+    d->cap = WSD_INIT_CAP;
+    d->top = d->bottom = 0;
+    return 0;
+}
+
+int wsdPush(wsdeque_t *d, const taskfun_t *task)
+{
+    LOCK_RETURN(&d->lock, -1);
+    if (d->bottom - d->top == d->cap)
+    { // deque piena: raddoppio la capacita' ricopiando i task in ordine
+        taskfun_t *nbuf = malloc(sizeof(taskfun_t) * d->cap * 2);
+        if (nbuf == NULL)
+        {
+            UNLOCK_RETURN(&d->lock, -1);
+            return -1;
+        }
+        for (size_t i = d->top; i != d->bottom; i++)
+            nbuf[i & (2 * d->cap - 1)] = d->buf[i & (d->cap - 1)];
+        free(d->buf);
+        d->buf = nbuf;
+        d->cap *= 2;
+    }
+    d->buf[d->bottom & (d->cap - 1)] = *task;
+    __atomic_store_n(&d->bottom, d->bottom + 1, __ATOMIC_RELEASE);
+    UNLOCK_RETURN(&d->lock, -1);
+    return 0;
+}
+
+int wsdPop(wsdeque_t *d, taskfun_t *task)
+{
+    if (wsdSize(d) == 0)
+        return -1;
+    LOCK_RETURN(&d->lock, -1);
+    int ret = -1;
+    if (d->bottom != d->top)
+    {
+        *task = d->buf[(d->bottom - 1) & (d->cap - 1)];
+        __atomic_store_n(&d->bottom, d->bottom - 1, __ATOMIC_RELEASE);
+        ret = 0;
+    }
+    UNLOCK_RETURN(&d->lock, -1);
+    return ret;
+}
+
+int wsdSteal(wsdeque_t *d, taskfun_t *task)
+{
+    if (wsdSize(d) == 0)
+        return -1;
+    LOCK_RETURN(&d->lock, -1);
+    int ret = -1;
+    if (d->bottom != d->top)
+    {
+        *task = d->buf[d->top & (d->cap - 1)];
+        __atomic_store_n(&d->top, d->top + 1, __ATOMIC_RELEASE);
+        ret = 0;
+    }
+    UNLOCK_RETURN(&d->lock, -1);
+    return ret;
+}
+
+void wsdDestroy(wsdeque_t *d)
+{
+    free(d->buf);
+    pthread_mutex_destroy(&d->lock);
+}
@@ -0,0 +1,228 @@
+/**********************************/
+//  implementation file wsum.c     /
+/*================================*/
+
+/*
+ * Le varianti vettoriali non usano moltiplicazioni a 64 bit (SSE2 e AVX2 non le hanno).
+ * Il vettore viene visto come B blocchi di V "corsie" (V = long per registro * registri srotolati)
+ * e per ogni corsia l si tengono due accumulatori:
+ *     P_l += x[b][l]        (somma dei valori)
+ *     Q_l += P_l            (somma delle somme parziali = sommatoria di (B - b) * x[b][l])
+ * alla fine sommatoria di b * x[b][l] = B * P_l - Q_l e quindi
+ *     sommatoria di i * x[i] = V * sommatoria(B * P_l - Q_l) + sommatoria(l * P_l)
+ * L'identita' vale in aritmetica modulo 2^64, per cui il risultato coincide bit a bit con la
+ * versione scalare anche in caso di overflow.
+ */
+
+// include
+#include <util.h>
+#include <wsum.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WSUM_X86 1
+#endif
+
+// numero di registri accumulatori indipendenti per variante (nasconde la latenza delle somme)
+#define WSUM_UNROLL 4
+
+long (*wsum)(const long *v, size_t n, long first) = wsum_scalar;
+
+/**
+ * @brief: versione scalare di riferimento
+ */
+long wsum_scalar(const long *v, size_t n, long first)
+{
+    unsigned long sum = 0;
+    unsigned long i = (unsigned long)first;
+    for (size_t j = 0; j < n; j++, i++)
+        sum += i * (unsigned long)v[j];
+    return (long)sum;
+}
+
+/**
+ * @brief: combina gli accumulatori delle corsie e aggiunge la coda non vettorizzata
+ * @param P somme dei valori per corsia
+ * @param Q somme delle somme parziali per corsia
+ * @param V numero di corsie
+ * @param B numero di blocchi processati
+ * @param v, n, first come in wsum
+ */
+static long wsum_finish(const unsigned long *P, const unsigned long *Q, size_t V, size_t B,
+                        const long *v, size_t n, long first)
+{
+    unsigned long plain = 0;    // sommatoria di x[i]
+    unsigned long weighted = 0; // sommatoria di i * x[i] (indici relativi a v)
+    unsigned long acc = 0;
+
+    for (size_t l = 0; l < V; l++)
+    {
+        plain += P[l];
+        acc += (unsigned long)B * P[l] - Q[l];
+        weighted += (unsigned long)l * P[l];
+    }
+    weighted += (unsigned long)V * acc;
+
+    // coda scalare
+    for (size_t i = B * V; i < n; i++)
+    {
+        plain += (unsigned long)v[i];
+        weighted += (unsigned long)i * (unsigned long)v[i];
+    }
+
+    return (long)((unsigned long)first * plain + weighted);
+}
+
+#ifdef WSUM_X86
+
+/**
+ * @brief: variante SSE2, 2 long per registro
+ */
+__attribute__((target("sse2"))) long wsum_sse2(const long *v, size_t n, long first)
+{
+    enum { L = 2, V = L * WSUM_UNROLL };
+    __m128i P[WSUM_UNROLL], Q[WSUM_UNROLL];
+    unsigned long p[V], q[V];
+    size_t B = n / V;
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+        P[u] = Q[u] = _mm_setzero_si128();
+
+    for (size_t b = 0; b < B; b++)
+    {
+        const __m128i *x = (const __m128i *)(v + b * V);
+        for (int u = 0; u < WSUM_UNROLL; u++)
+        {
+            P[u] = _mm_add_epi64(P[u], _mm_loadu_si128(x + u));
+            Q[u] = _mm_add_epi64(Q[u], P[u]);
+        }
+    }
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+    {
+        _mm_storeu_si128((__m128i *)(p + u * L), P[u]);
+        _mm_storeu_si128((__m128i *)(q + u * L), Q[u]);
+    }
+    return wsum_finish(p, q, V, B, v, n, first);
+}
+
+/**
+ * @brief: variante AVX2, 4 long per registro
+ */
+__attribute__((target("avx2"))) long wsum_avx2(const long *v, size_t n, long first)
+{
+    enum { L = 4, V = L * WSUM_UNROLL };
+    __m256i P[WSUM_UNROLL], Q[WSUM_UNROLL];
+    unsigned long p[V], q[V];
+    size_t B = n / V;
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+        P[u] = Q[u] = _mm256_setzero_si256();
+
+    for (size_t b = 0; b < B; b++)
+    {
+        const __m256i *x = (const __m256i *)(v + b * V);
+        for (int u = 0; u < WSUM_UNROLL; u++)
+        {
+            P[u] = _mm256_add_epi64(P[u], _mm256_loadu_si256(x + u));
+            Q[u] = _mm256_add_epi64(Q[u], P[u]);
+        }
+    }
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+    {
+        _mm256_storeu_si256((__m256i *)(p + u * L), P[u]);
+        _mm256_storeu_si256((__m256i *)(q + u * L), Q[u]);
+    }
+    return wsum_finish(p, q, V, B, v, n, first);
+}
+
+/**
+ * @brief: variante AVX-512 (AVX512F), 8 long per registro
+ */
+__attribute__((target("avx512f"))) long wsum_avx512(const long *v, size_t n, long first)
+{
+    enum { L = 8, V = L * WSUM_UNROLL };
+    __m512i P[WSUM_UNROLL], Q[WSUM_UNROLL];
+    unsigned long p[V], q[V];
+    size_t B = n / V;
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+        P[u] = Q[u] = _mm512_setzero_si512();
+
+    for (size_t b = 0; b < B; b++)
+    {
+        const long *x = v + b * V;
+        for (int u = 0; u < WSUM_UNROLL; u++)
+        {
+            P[u] = _mm512_add_epi64(P[u], _mm512_loadu_si512((const void *)(x + u * L)));
+            Q[u] = _mm512_add_epi64(Q[u], P[u]);
+        }
+    }
+
+    for (int u = 0; u < WSUM_UNROLL; u++)
+    {
+        _mm512_storeu_si512((void *)(p + u * L), P[u]);
+        _mm512_storeu_si512((void *)(q + u * L), Q[u]);
+    }
+    return wsum_finish(p, q, V, B, v, n, first);
+}
+
+#else // architettura non x86: le varianti vettoriali coincidono con quella scalare
+
+long wsum_sse2(const long *v, size_t n, long first) { return wsum_scalar(v, n, first); }
+long wsum_avx2(const long *v, size_t n, long first) { return wsum_scalar(v, n, first); }
+long wsum_avx512(const long *v, size_t n, long first) { return wsum_scalar(v, n, first); }
+
+#endif // WSUM_X86
+
+/**
+ * @struct wsum_variant
+ * @brief associa il nome di una variante alla funzione e alla feature della CPU richiesta
+ */
+struct wsum_variant
+{
+    const char *name;                        // nome usato anche da FARM_WSUM
+    long (*fun)(const long *, size_t, long); // implementazione
+    int supported;                           // 1 se la CPU supporta la variante
+};
+
+const char *wsum_init(void)
+{
+    // in ordine di preferenza crescente
+    struct wsum_variant variants[] = {
+        {"scalar", wsum_scalar, 1},
+        {"sse2", wsum_sse2, 0},
+        {"avx2", wsum_avx2, 0},
+        {"avx512", wsum_avx512, 0},
+    };
+    int nvariants = sizeof(variants) / sizeof(variants[0]);
+
+#ifdef WSUM_X86
+    __builtin_cpu_init();
+    variants[1].supported = __builtin_cpu_supports("sse2");
+    variants[2].supported = __builtin_cpu_supports("avx2");
+    variants[3].supported = __builtin_cpu_supports("avx512f");
+#endif
+
+    int best = 0;
+    for (int i = 0; i < nvariants; i++)
+        if (variants[i].supported)
+            best = i;
+
+    const char *forced = getenv("FARM_WSUM");
+    if (forced != NULL)
+    {
+        int i;
+        for (i = 0; i < nvariants; i++)
+            if (strcmp(forced, variants[i].name) == 0)
+                break;
+        if (i < nvariants && variants[i].supported)
+            best = i;
+        else
+            fprintf(stderr, "FARM_WSUM=%s non supportata, uso %s\n", forced, variants[best].name);
+    }
+
+    wsum = variants[best].fun;
+    return variants[best].name;
+}
@@ -0,0 +1,97 @@
+/*****************************************************************************************/
+/** Progetto Farm
+ * Laboratorio di sistemi Operativi
+ * @author Andrea Lepori
+ * @file : wsumcheck.c
+ * @brief : verifica diretta delle varianti vettoriali del kernel di calcolo: chiama wsum_sse2, wsum_avx2 e
+ *          wsum_avx512 e confronta il risultato con wsum_scalar su lunghezze dispari, code non multiple della
+ *          larghezza dei vettori e inizi non allineati, con valori pseudo-casuali che vanno in overflow.
+ *          Le varianti non supportate dalla CPU vengono saltate con "SKIP". Uso: ./wsumcheck
+ */
+/*=======================================================================================*/
+
+#define _POSIX_C_SOURCE 200112L
+
+// include
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <wsum.h>
+
+// lunghezze provate: tutte fino a MAXSMALL e alcune grandi, ogni lunghezza anche con inizio spostato di 1..7 long
+#define MAXSMALL 130
+#define MAXSHIFT 8
+#define NLONG (100003 + MAXSHIFT)
+
+int main(void)
+{
+    struct
+    {
+        const char *name;
+        long (*fun)(const long *, size_t, long);
+        const char *feature;
+    } variants[] = {
+        {"sse2", wsum_sse2, "sse2"},
+        {"avx2", wsum_avx2, "avx2"},
+        {"avx512", wsum_avx512, "avx512f"},
+    };
+    size_t big[] = {1001, 4099, 100003};
+    long firsts[] = {0, 1, 12345, LONG_MAX - 3};
+
+    long *v = malloc(NLONG * sizeof(long));
+    if (v == NULL)
+    {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+    unsigned long x = 88172645463325252UL; // xorshift64
+    for (size_t i = 0; i < NLONG; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        v[i] = (long)(x >> 1) - (long)(x & 0xFFFF); // valori grandi di entrambi i segni
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+#endif
+    int failed = 0;
+    for (size_t k = 0; k < sizeof(variants) / sizeof(variants[0]); k++)
+    {
+        int supported = 1;
+#if defined(__x86_64__) || defined(__i386__)
+        // __builtin_cpu_supports vuole una costante stringa
+        if (k == 0)
+            supported = __builtin_cpu_supports("sse2");
+        else if (k == 1)
+            supported = __builtin_cpu_supports("avx2");
+        else
+            supported = __builtin_cpu_supports("avx512f");
+#endif
+        if (!supported)
+        {
+            printf("wsum %s: SKIP (%s non supportata dalla CPU)\n", variants[k].name, variants[k].feature);
+            continue;
+        }
+
+        long errors = 0, checks = 0;
+        for (size_t s = 0; s < MAXSHIFT; s++)
+            for (size_t f = 0; f < sizeof(firsts) / sizeof(firsts[0]); f++)
+                for (size_t t = 0; t <= MAXSMALL + sizeof(big) / sizeof(big[0]); t++)
+                {
+                    size_t n = (t <= MAXSMALL) ? t : big[t - MAXSMALL - 1];
+                    long atteso = wsum_scalar(v + s, n, firsts[f]);
+                    long ottenuto = variants[k].fun(v + s, n, firsts[f]);
+                    checks++;
+                    if (ottenuto != atteso && errors++ < 5)
+                        printf("wsum %s con %zu long da v+%zu, first %ld: atteso %ld, ottenuto %ld\n",
+                               variants[k].name, n, s, firsts[f], atteso, ottenuto);
+                }
+        printf("wsum %s: %s (%ld confronti)\n", variants[k].name, errors ? "FAILED" : "ok", checks);
+        if (errors)
+            failed = 1;
+    }
+    free(v);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -105,3 +105,275 @@ if [[ $? != 0 ]]; then
 else
     echo "test5 passed"
 fi
+
+#
+# verifica del kernel di calcolo: ogni variante (scalare e vettoriali) deve dare
+# il "risultato atteso" stampato da generafile, anche con un numero di long
+# che non e' multiplo della larghezza dei vettori. Una variante forzata con
+# FARM_WSUM e non supportata dalla CPU ripiega su un'altra, per cui wsumcheck
+# chiama direttamente ogni variante supportata (le altre sono SKIP)
+#
+mkdir -p wsumdir
+failed=0
+./wsumcheck || failed=1
+for nelem in 1 7 33 1000 100003; do
+    atteso=$(./generafile wsumdir/wsum$nelem.dat $nelem | awk '{print $3}')
+    for variante in scalar sse2 avx2 avx512; do
+        ottenuto=$(FARM_WSUM=$variante ./farm -n 1 wsumdir/wsum$nelem.dat | awk '{print $1}')
+        if [[ "$ottenuto" != "$atteso" ]]; then
+            echo "wsum $variante con $nelem long: atteso $atteso, ottenuto $ottenuto"
+            failed=1
+        fi
+    done
+done
+rm -r wsumdir
+if [[ $failed != 0 ]]; then
+    echo "test6 failed"
+else
+    echo "test6 passed"
+fi
+
+# esecuzione con i file suddivisi in chunk da 64 byte calcolati in parallelo
+./farm -n 4 -q 4 -c 64 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test7 failed"
+else
+    echo "test7 passed"
+fi
+
+# esecuzione con la politica di schedulazione lpt (prima i file piu' grandi) e finestra di 3 file
+./farm -n 2 -q 2 -S lpt -w 3 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test8 failed"
+else
+    echo "test8 passed"
+fi
+
+# esecuzione con la coda dei task lock-free, 8 thread e coda lunga 2
+./farm -n 8 -q 2 -Q lockfree file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test9 failed"
+else
+    echo "test9 passed"
+fi
+
+# esecuzione con il pool a work stealing, 8 thread e coda lunga 2
+./farm -n 8 -q 2 -Q steal -c 256 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test10 failed"
+else
+    echo "test10 passed"
+fi
+
+# sottomissione a lotti con una coda lunga 1: il lotto riempie la coda a meta' dell'inserimento
+./farm -n 3 -q 1 -t 0 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test11 failed"
+else
+    echo "test11 passed"
+fi
+
+# esplorazione della directory con 8 thread, con e senza stat dei file (suddivisione in chunk) e con ritardo
+./farm -n 4 -q 2 -W 8 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -n 4 -q 2 -W 8 -c 128 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -n 4 -q 2 -W 8 -t 1 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test12 failed"
+else
+    echo "test12 passed"
+fi
+
+# esecuzione con 100 thread, il collector gestisce una connessione per worker
+./farm -n 100 -q 4 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test13 failed"
+else
+    echo "test13 passed"
+fi
+
+# lista ordinata del collector: 200000 inserimenti con molte chiavi uguali, verifica dell'ordinamento
+./benchlist 200000 > /dev/null
+if [[ $? != 0 ]]; then
+    echo "test14 failed"
+else
+    echo "test14 passed"
+fi
+
+# modalita' append del collector: i risultati vengono ordinati solo alla stampa (radix sort e fusione)
+./farm -a -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./benchlist -a 200000 > /dev/null
+if [[ $? != 0 ]]; then
+    echo "test15 failed"
+else
+    echo "test15 passed"
+fi
+
+# protocollo tra worker e collector: versione 1 (un messaggio per risultato) e versione 2 (frame) con tutte le code
+./farm -P 1 -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -P 2 -n 4 -q 2 -Q lockfree file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -P 2 -n 4 -q 2 -Q steal -c 256 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test16 failed"
+else
+    echo "test16 passed"
+fi
+
+# risultati dei worker in memoria condivisa (protocollo 3), anche con 100 anelli e con il collector in modalita' append
+./farm -P 3 -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -P 3 -n 4 -q 2 -Q steal -c 256 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -P 3 -n 100 -q 4 -a file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test17 failed"
+else
+    echo "test17 passed"
+fi
+
+# collector interno alla farm: nessun processo collector, anche in modalita' append e con il work stealing
+./farm --inproc-collector -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm --inproc-collector -a -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm --inproc-collector -n 4 -q 2 -Q steal -c 256 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test18 failed"
+else
+    echo "test18 passed"
+fi
+
+# cache persistente dei risultati: la seconda esecuzione usa la cache, un file riscritto viene ricalcolato
+rm -rf tcache farm.cache && mkdir tcache && cp file1.dat tcache/f.dat && \
+./farm -C farm.cache -n 4 -q 2 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -C farm.cache -n 4 -q 2 -c 256 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -C farm.cache -n 4 -q 2 -d tcache | grep -q "^153259244 tcache/f.dat" && \
+cat file2.dat > tcache/f.dat && \
+./farm -C farm.cache -n 4 -q 2 -d tcache | grep -q "^103453975 tcache/f.dat"
+if [[ $? != 0 ]]; then
+    echo "test19 failed"
+else
+    echo "test19 passed"
+fi
+rm -rf tcache farm.cache
+
+# modalita' incrementale: un file esteso in coda riparte dal checkpoint, uno riscritto (in coda o in testa) viene ricalcolato da capo
+rm -rf tinc inc.cache && mkdir tinc && cp file1.dat tinc/f.dat && cp file2.dat tinc/g.dat && \
+./farm -C inc.cache -i -n 4 -q 2 -d tinc > /dev/null && \
+cat file2.dat >> tinc/f.dat && cat file3.dat file1.dat > tinc/g.dat && \
+./farm -n 4 -q 2 -d tinc > tinc.expected && \
+./farm -C inc.cache -i -n 4 -q 2 -d tinc | diff - tinc.expected && \
+cat file4.dat >> tinc/f.dat && ./farm -n 4 -q 2 -d tinc > tinc.expected && \
+./farm -C inc.cache -i -n 4 -q 2 -c 256 -d tinc | diff - tinc.expected && \
+printf 'riscritto' | dd of=tinc/f.dat conv=notrunc status=none && cat file5.dat >> tinc/f.dat && \
+./farm -n 4 -q 2 -d tinc > tinc.expected && \
+./farm -C inc.cache --append-only -n 4 -q 2 -d tinc | diff - tinc.expected
+if [[ $? != 0 ]]; then
+    echo "test20 failed"
+else
+    echo "test20 passed"
+fi
+rm -rf tinc inc.cache tinc.expected
+
+# osservazione continua della directory: i file scritti o spostati dopo l'avvio, anche in nuove sottodirectory
+rm -rf twatch twatch.out && mkdir twatch && cp file1.dat twatch/
+./farm --watch -n 4 -q 2 -d twatch > twatch.out &
+pid=$!
+sleep 1
+cp file2.dat twatch/ && mkdir twatch/sub && cp file3.dat twatch/sub/ && cp file4.dat farm.tmp && mv farm.tmp twatch/sub/f4.dat
+sleep 1
+kill -INT $pid
+wait $pid
+grep -q "^153259244 twatch/file1.dat" twatch.out && grep -q "^103453975 twatch/file2.dat" twatch.out && \
+grep -q "^293718900 twatch/sub/file3.dat" twatch.out && grep -q "^584164283 twatch/sub/f4.dat" twatch.out
+if [[ $? != 0 ]]; then
+    echo "test21 failed"
+else
+    echo "test21 passed"
+fi
+rm -rf twatch twatch.out
+
+# server di job: due job concorrenti sullo stesso threadpool, ciascuno riceve solo i propri risultati ordinati
+rm -f job.sck
+./farm -n 4 -q 2 --server job.sck > /dev/null &
+pid=$!
+sleep 1
+./farm --submit job.sck file* -d testdir > job1.out &
+job1=$!
+./farm --submit job.sck file1.dat file2.dat > job2.out
+wait $job1
+kill -INT $pid
+wait $pid
+grep "file*" job1.out | awk '{print $1,$2}' | diff - expected.txt && \
+grep -c "dat" job2.out | grep -q "^2$" && head -1 job2.out | grep -q "^JOB"
+if [[ $? != 0 ]]; then
+    echo "test22 failed"
+else
+    echo "test22 passed"
+fi
+rm -f job1.out job2.out
+
+# elenco dei file letto in streaming (righe o separatori '\0'), i pathname non validi vengono scartati dal worker
+(ls file*; echo nonesiste.dat; echo testdir; find testdir -type f) | ./farm -n 4 -q 2 --files-from - 2> /dev/null | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+(printf '%s\0' file*; find testdir -type f -print0) > farm.list && \
+./farm -n 4 -q 2 -c 256 --null --files-from farm.list | grep "file*" | awk '{print $1,$2}' | diff - expected.txt
+if [[ $? != 0 ]]; then
+    echo "test23 failed"
+else
+    echo "test23 passed"
+fi
+rm -f farm.list
+
+# journal dei risultati: con --resume i file gia' nel journal non vengono ricalcolati (tj.dat viene svuotato dopo
+# il primo run ma mantiene il risultato registrato) e un record finale incompleto viene scartato
+cp file1.dat tj.dat
+rm -f farm.jrn
+./farm -n 4 -q 2 --journal farm.jrn tj.dat > /dev/null
+: > tj.dat
+printf 'torn' >> farm.jrn
+(echo tj.dat; ls file*; find testdir -type f) | ./farm -n 4 -q 2 --journal farm.jrn --resume --files-from - > jr.out && \
+grep -q "^153259244 tj.dat" jr.out && grep "file*" jr.out | awk '{print $1,$2}' | diff - expected.txt && \
+./farm -n 4 -q 2 --inproc-collector --journal farm.jrn --resume tj.dat | diff - jr.out
+if [[ $? != 0 ]]; then
+    echo "test24 failed"
+else
+    echo "test24 passed"
+fi
+rm -f tj.dat farm.jrn jr.out
+
+# velocita' di sottomissione limitata: 21 file a 20 file/s con una raffica di 2 file richiedono almeno 0.95 s
+start=$(date +%s%N)
+./farm -n 4 -q 2 --rate-files 20 --rate-bytes 100000000 file* -d testdir | grep "file*" | awk '{print $1,$2}' | diff - expected.txt && \
+[[ $(( ($(date +%s%N) - start) / 1000000 )) -ge 900 ]]
+if [[ $? != 0 ]]; then
+    echo "test25 failed"
+else
+    echo "test25 passed"
+fi
+
+# file troncato mentre un worker lo legge mappato: la farm non termina con SIGBUS e prosegue con gli altri file
+rm -f tbus.dat
+truncate -s 4G tbus.dat
+./farm -n 2 tbus.dat file1.dat > tbus.out &
+pid=$!
+sleep 0.1
+truncate -s 8192 tbus.dat
+wait $pid && grep -q "^0 tbus.dat" tbus.out && grep -q "^153259244 file1.dat" tbus.out
+if [[ $? != 0 ]]; then
+    echo "test26 failed"
+else
+    echo "test26 passed"
+fi
+rm -f tbus.dat tbus.out
+
+# un risultato accodato non aspetta la fine del task successivo: la stampa chiesta con SIGUSR1 durante il calcolo
+# di un file grande contiene gia' il file piccolo calcolato prima
+rm -f tbig.dat
+truncate -s 4G tbig.dat
+./farm -n 1 -q 1 file1.dat tbig.dat > tbig.out &
+pid=$!
+sleep 0.5
+kill -USR1 $pid
+wait $pid
+grep -c "file1.dat" tbig.out | grep -q "^2$"
+if [[ $? != 0 ]]; then
+    echo "test27 failed"
+else
+    echo "test27 passed"
+fi
+rm -f tbig.dat tbig.out